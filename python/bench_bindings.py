@@ -0,0 +1,62 @@
+import argparse, time
+import numpy as np
+import sacpy
+
+def rate(n, fn):
+    t0 = time.perf_counter()
+    fn()
+    return n / (time.perf_counter() - t0)
+
+def main():
+    ap = argparse.ArgumentParser(description="sacpy 吞吐基准")
+    ap.add_argument("--envs", type=int, default=256, help="批量环境个数")
+    ap.add_argument("--steps", type=int, default=2000, help="批量 step 次数")
+    ap.add_argument("--updates", type=int, default=200, help="SAC update 次数")
+    ap.add_argument("--batch", type=int, default=256)
+    args = ap.parse_args()
+
+    n, T = args.envs, args.steps
+    env = sacpy.BatchedPendulum(n)
+    obs = env.reset(123)
+    rng = np.random.default_rng(0)
+    actions = rng.uniform(-2.0, 2.0, size=(T, n)).astype(np.float32)
+
+    # 1) 批量环境：单次调用推进 n 个环境
+    def run_env():
+        for t in range(T):
+            env.step(actions[t])
+    print(f"env steps/sec      : {rate(n * T, run_env):,.0f}  ({n} envs x {T} steps)")
+
+    # 2) 回放写入：整批 push，一次跨语言调用
+    buf = sacpy.ReplayBuffer(n * T, 3, 1)
+    S = rng.standard_normal((n * T, 3), dtype=np.float32)
+    A = actions.reshape(-1, 1)
+    R = rng.standard_normal(n * T, dtype=np.float32)
+    D = np.zeros(n * T, dtype=np.float32)
+    chunk = n
+    def run_push():
+        for i in range(0, n * T, chunk):
+            buf.push(S[i:i+chunk], A[i:i+chunk], R[i:i+chunk], S[i:i+chunk], D[i:i+chunk])
+    print(f"replay push/sec    : {rate(n * T, run_push):,.0f}  (memory {buf.memory_bytes() / 2**20:.1f} MB)")
+
+    # 3) 采样：返回 numpy 视图（无拷贝）
+    K = 1000
+    def run_sample():
+        for _ in range(K):
+            buf.sample(args.batch)
+    print(f"samples/sec        : {rate(K * args.batch, run_sample):,.0f}  (batch {args.batch})")
+
+    # 4) SAC update：n 次 update 在一次调用内完成，期间释放 GIL
+    cfg = sacpy.SACConfig()
+    cfg.batch_size = args.batch
+    agent = sacpy.SACAgent(cfg)
+    print(f"updates/sec        : {rate(args.updates, lambda: agent.update(buf, args.updates)):,.1f}")
+
+    # 5) 批量推理
+    def run_act():
+        for _ in range(100):
+            agent.act(obs, deterministic=True)
+    print(f"batched act/sec    : {rate(100 * n, run_act):,.0f}  ({n} states per call)")
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,222 @@
+// pybind11 模块 sacpy：暴露 PendulumEnv / 批量环境 / ReplayBuffer / SACAgent。
+// 数组进出都是 float32 numpy：输入直接 from_blob 零拷贝读取，
+// 输出把 torch::Tensor 的存储包成 numpy 视图（capsule 持有张量，不拷贝），
+// Python 侧可再用 torch.from_numpy 得到共享内存的张量。
+// 重计算（批量 step / push / sample / update）期间释放 GIL；
+// ReplayBuffer 本身不是线程安全的，绑定层用 SharedReplay 的互斥锁串行化对它的访问。
+#include <pybind11/pybind11.h>
+#include <pybind11/numpy.h>
+#include <pybind11/stl.h>
+#include <torch/torch.h>
+#include <mutex>
+#include <vector>
+
+#include "env/pendulum.h"
+#include "sac/sac_agent.h"
+#include "utils/replay_buffer.h"
+
+namespace py = pybind11;
+using farray = py::array_t<float, py::array::c_style | py::array::forcecast>;
+
+namespace {
+
+// 张量 -> numpy 视图（零拷贝，numpy 数组持有张量引用）
+py::array_t<float> as_numpy(torch::Tensor t) {
+    t = t.to(torch::kFloat32).contiguous();
+    auto* holder = new torch::Tensor(t);
+    py::capsule owner(holder, [](void* p) { delete static_cast<torch::Tensor*>(p); });
+    std::vector<py::ssize_t> shape(t.sizes().begin(), t.sizes().end());
+    std::vector<py::ssize_t> strides;
+    for (auto s : t.strides()) strides.push_back(s * (py::ssize_t)sizeof(float));
+    return py::array_t<float>(shape, strides, holder->data_ptr<float>(), owner);
+}
+
+// numpy -> 张量视图（零拷贝；调用方保证 arr 在使用期间存活）
+torch::Tensor as_tensor(const farray& arr) {
+    std::vector<int64_t> shape(arr.shape(), arr.shape() + arr.ndim());
+    return torch::from_blob(const_cast<float*>(arr.data()), shape, torch::kFloat32);
+}
+
+py::array_t<float> obs_array(const std::array<double,3>& s) {
+    py::array_t<float> out(3);
+    auto* p = out.mutable_data();
+    for (int i=0; i<3; ++i) p[i] = (float)s[i];
+    return out;
+}
+
+// a 必须恰好是 n 行 cols 列：[n,cols]；n==1 时可为一维 [cols]；cols==1 时可为 [n]（或 n==1 的标量）
+void require_rows(const farray& a, py::ssize_t n, py::ssize_t cols, const char* name) {
+    const bool ok = (a.ndim() == 2 && a.shape(0) == n && a.shape(1) == cols) ||
+                    (a.ndim() == 1 && ((n == 1 && a.shape(0) == cols) || (cols == 1 && a.shape(0) == n))) ||
+                    (a.ndim() == 0 && n == 1 && cols == 1);
+    if (!ok) throw std::invalid_argument(std::string(name) + " has wrong shape");
+}
+
+// 一组独立的 Pendulum，按批 step，结果写入连续数组
+class BatchedPendulum {
+public:
+    explicit BatchedPendulum(int n) : envs_(n) {}
+    int size() const { return (int)envs_.size(); }
+
+    py::array_t<float> reset(unsigned int seed) {
+        py::array_t<float> obs({(py::ssize_t)envs_.size(), (py::ssize_t)3});
+        float* o = obs.mutable_data();
+        {
+            py::gil_scoped_release nogil;
+            for (size_t i=0; i<envs_.size(); ++i) write_obs_(o + 3*i, envs_[i].reset(seed + (unsigned)i));
+        }
+        return obs;
+    }
+
+    // actions: [N] -> (obs [N,3], reward [N])
+    py::tuple step(const farray& actions) {
+        const py::ssize_t n = (py::ssize_t)envs_.size();
+        require_rows(actions, n, 1, "actions");
+        py::array_t<float> obs({n, (py::ssize_t)3});
+        py::array_t<float> rew(n);
+        const float* a = actions.data();
+        float* o = obs.mutable_data();
+        float* r = rew.mutable_data();
+        {
+            py::gil_scoped_release nogil;
+            for (py::ssize_t i=0; i<n; ++i) {
+                auto out = envs_[i].step(a[i]);
+                write_obs_(o + 3*i, out.state);
+                r[i] = (float)out.reward;
+            }
+        }
+        return py::make_tuple(obs, rew);
+    }
+
+private:
+    std::vector<PendulumEnv> envs_;
+    static void write_obs_(float* dst, const std::array<double,3>& s) {
+        dst[0] = (float)s[0]; dst[1] = (float)s[1]; dst[2] = (float)s[2];
+    }
+};
+
+// Python 侧的 ReplayBuffer：释放 GIL 后采集线程 push、学习线程 update 可能并发，
+// 所有对 buf 的读写都在 mu 下进行（sample 返回的是拷贝，解锁后可安全使用）
+struct SharedReplay {
+    ReplayBuffer buf;
+    mutable std::mutex mu;
+
+    SharedReplay(size_t capacity, int obs_dim, int act_dim, torch::Dtype dtype)
+        : buf(capacity, obs_dim, act_dim, dtype) {}
+
+    size_t size() const { std::lock_guard<std::mutex> lk(mu); return buf.size(); }
+    size_t memory_bytes() const { std::lock_guard<std::mutex> lk(mu); return buf.memory_bytes(); }
+};
+
+torch::Dtype parse_dtype(const std::string& v) {
+    if (v == "bf16") return torch::kBFloat16;
+    if (v == "fp16") return torch::kHalf;
+    if (v == "fp32") return torch::kFloat32;
+    throw std::invalid_argument("dtype must be fp32, fp16 or bf16");
+}
+
+} // namespace
+
+PYBIND11_MODULE(sacpy, m) {
+    m.doc() = "Pendulum SAC (libtorch) bindings";
+
+    py::class_<PendulumEnv>(m, "PendulumEnv")
+        .def(py::init<>())
+        .def("reset", [](PendulumEnv& e, unsigned int seed) { return obs_array(e.reset(seed)); },
+             py::arg("seed") = 0)
+        .def("step", [](PendulumEnv& e, double a) {
+            auto out = e.step(a);
+            return py::make_tuple(obs_array(out.state), out.reward, out.done);
+        });
+
+    py::class_<BatchedPendulum>(m, "BatchedPendulum")
+        .def(py::init<int>(), py::arg("n"))
+        .def("__len__", &BatchedPendulum::size)
+        .def("reset", &BatchedPendulum::reset, py::arg("seed") = 0)
+        .def("step", &BatchedPendulum::step, py::arg("actions"));
+
+    py::class_<SharedReplay>(m, "ReplayBuffer")
+        .def(py::init([](size_t capacity, int obs_dim, int act_dim, const std::string& dtype) {
+                 return std::make_unique<SharedReplay>(capacity, obs_dim, act_dim, parse_dtype(dtype));
+             }),
+             py::arg("capacity"), py::arg("obs_dim") = 3, py::arg("act_dim") = 1, py::arg("dtype") = "fp32")
+        .def("__len__", &SharedReplay::size)
+        .def("memory_bytes", &SharedReplay::memory_bytes)
+        // 批量写入：S[N,obs] A[N,act] R[N] S2[N,obs] D[N]
+        .def("push", [](SharedReplay& b, const farray& S, const farray& A, const farray& R,
+                        const farray& S2, const farray& D) {
+            // 形状一律按缓冲区自身的维度检查（维度构造后不变，无需加锁），push_batch 按这些维度步进
+            const py::ssize_t n = S.ndim() == 2 ? S.shape(0) : 1;
+            require_rows(S, n, b.buf.obs_dim(), "S");  require_rows(S2, n, b.buf.obs_dim(), "S2");
+            require_rows(A, n, b.buf.act_dim(), "A");  require_rows(R, n, 1, "R");
+            require_rows(D, n, 1, "D");
+            py::gil_scoped_release nogil;
+            std::lock_guard<std::mutex> lk(b.mu);
+            b.buf.push_batch(S.data(), A.data(), R.data(), S2.data(), D.data(), (size_t)n);
+        }, py::arg("s"), py::arg("a"), py::arg("r"), py::arg("s2"), py::arg("d"))
+        .def("sample", [](SharedReplay& b, size_t batch) {
+            std::tuple<torch::Tensor,torch::Tensor,torch::Tensor,torch::Tensor,torch::Tensor> out;
+            {
+                py::gil_scoped_release nogil;
+                std::lock_guard<std::mutex> lk(b.mu);
+                if (b.buf.size() > 0) out = b.buf.sample(batch, torch::kCPU);
+            }
+            if (!std::get<0>(out).defined()) throw std::runtime_error("ReplayBuffer is empty");
+            auto& [S, A, R, S2, D] = out;
+            return py::make_tuple(as_numpy(S), as_numpy(A), as_numpy(R), as_numpy(S2), as_numpy(D));
+        }, py::arg("batch_size"));
+
+    py::class_<SACConfig>(m, "SACConfig")
+        .def(py::init<>())
+        .def_readwrite("obs_dim", &SACConfig::obs_dim)
+        .def_readwrite("act_dim", &SACConfig::act_dim)
+        .def_readwrite("act_limit", &SACConfig::act_limit)
+        .def_readwrite("gamma", &SACConfig::gamma)
+        .def_readwrite("tau", &SACConfig::tau)
+        .def_readwrite("hidden", &SACConfig::hidden)
+        .def_readwrite("batch_size", &SACConfig::batch_size)
+        .def_readwrite("lr", &SACConfig::lr)
+        .def_readwrite("autotune_alpha", &SACConfig::autotune_alpha)
+        .def_readwrite("target_entropy", &SACConfig::target_entropy)
+        .def_readwrite("updates_per_step", &SACConfig::updates_per_step)
+        .def_readwrite("autocast_bf16", &SACConfig::autocast_bf16)
+        .def_readwrite("critic_split", &SACConfig::critic_split);
+
+    py::class_<SACAgent>(m, "SACAgent")
+        .def(py::init([](const SACConfig& cfg) { return std::make_unique<SACAgent>(cfg, torch::kCPU); }),
+             py::arg("config") = SACConfig{})
+        // 连续做 n 次 update，整个过程不持有 GIL；只有采样持有缓冲区锁，
+        // 前向/反向期间其他线程仍可 push
+        .def("update", [](SACAgent& a, SharedReplay& b, int n) {
+            const size_t B = (size_t)a.config().batch_size;
+            for (int i=0; i<n; ++i) {
+                std::tuple<torch::Tensor,torch::Tensor,torch::Tensor,torch::Tensor,torch::Tensor> batch;
+                {
+                    std::lock_guard<std::mutex> lk(b.mu);
+                    if (b.buf.size() < B) return;
+                    batch = b.buf.sample(B, torch::kCPU);
+                }
+                auto& [S, A, R, S2, D] = batch;
+                a.update_on_batch(S, A, R, S2, D);
+            }
+        }, py::arg("buffer"), py::arg("n") = 1, py::call_guard<py::gil_scoped_release>())
+        // obs: [obs_dim] 或 [N,obs_dim]；返回真实尺度动作 [N,act_dim]
+        .def("act", [](SACAgent& a, const farray& obs, bool deterministic) {
+            auto S = as_tensor(obs);
+            torch::Tensor act;
+            {
+                py::gil_scoped_release nogil;
+                torch::NoGradGuard ng;
+                if (S.dim() == 1) S = S.unsqueeze(0);
+                auto a01 = deterministic ? a.actor()->act_deterministic(S)
+                                         : a.actor()->sample_action_and_logp(S).first;
+                act = a01 * a.config().act_limit;
+            }
+            return as_numpy(act);
+        }, py::arg("obs"), py::arg("deterministic") = false)
+        .def("save", &SACAgent::save, py::arg("dir"), py::call_guard<py::gil_scoped_release>())
+        .def("load", [](SACAgent& a, const std::string& dir) { return a.load(dir, torch::kCPU); },
+             py::arg("dir"), py::call_guard<py::gil_scoped_release>())
+        .def("export_policy", &SACAgent::export_policy, py::arg("path"))
+        .def_property_readonly("alpha", &SACAgent::alpha);
+}
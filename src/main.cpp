@@ -6,13 +6,35 @@
 #include <filesystem>
 #include <fstream>
 #include <sstream>
+#include <chrono>
+#include <algorithm>
+#include <memory>
+#include <functional>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <fcntl.h>
+#include <sched.h>
+#include <spawn.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include "env/pendulum.h"
 #include "sac/sac_agent.h"
+#include "sac/async_evaluator.h"
+#include "sac/student.h"
 #include "utils/replay_buffer.h"
 #include "utils/logger.h"
 #include "vis/renderer.h"
 #include "utils/state_io.h"   // <-- 新增：state.json 读写
+#include "utils/proc_info.h"
+#include "runtime/policy_runtime.h"
+#include "utils/offline_dataset.h"
+#include "utils/mem_stats.h"
+#include "utils/metrics.h"
+#include "runtime/realtime.h"
+#include <nlohmann/json.hpp>
 
 namespace fs = std::filesystem;
 
@@ -30,12 +52,68 @@ static bool has_flag(int argc, char** argv, const std::string& flag) {
 static double angle_from_obs(const std::array<double,3>& s) {
     return std::atan2(s[1], s[0]); // [-pi, pi], 0=up
 }
+static torch::Tensor obs_to_tensor(const std::array<double,3>& s) {
+    return torch::tensor({(float)s[0], (float)s[1], (float)s[2]}, torch::kFloat32);
+}
+
+// replay_dtype: fp32 | fp16 | bf16（obs/act 的存储精度）
+static torch::Dtype replay_dtype_from(const YAML::Node& y) {
+    const std::string v = y["replay_dtype"] ? y["replay_dtype"].as<std::string>() : "fp32";
+    if (v == "bf16") return torch::kBFloat16;
+    if (v == "fp16") return torch::kHalf;
+    return torch::kFloat32;
+}
+
+// 固定种子（1000+e）跑确定性策略，返回平均回报（不渲染）。act(state_tensor) -> 真实尺度动作
+template <typename ActFn>
+static double run_eval_episodes(ActFn&& act, PendulumEnv& env, int episodes, int max_ep_len) {
+    double avg = 0.0;
+    for (int e=0; e<episodes; ++e) {
+        auto st = obs_to_tensor(env.reset(1000 + e));
+        double er = 0.0;
+        for (int t=0; t<max_ep_len; ++t) {
+            auto o2 = env.step(act(st));
+            er += o2.reward;
+            st = obs_to_tensor(o2.state);
+        }
+        avg += er;
+    }
+    return avg / episodes;
+}
+
+static double evaluate_policy(SACAgent& agent, PendulumEnv& env, int episodes, int max_ep_len) {
+    return run_eval_episodes([&](const torch::Tensor& s) { return agent.select_action_eval(s); },
+                             env, episodes, max_ep_len);
+}
+
+// 把 overlay 的顶层键覆盖到 base 上（config 是扁平的，不做深合并）
+static void merge_overlay(YAML::Node& base, const YAML::Node& overlay) {
+    for (const auto& kv : overlay) base[kv.first.as<std::string>()] = kv.second;
+}
+
+// 线程配置：必须在 libtorch 建线程池之前调用。cpu_affinity 为空时不绑核
+static void apply_thread_config(const YAML::Node& y) {
+    if (y["cpu_affinity"] && y["cpu_affinity"].IsSequence() && y["cpu_affinity"].size() > 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (const auto& c : y["cpu_affinity"]) CPU_SET(c.as<int>(), &set);
+        // 之后创建的 libtorch 工作线程继承主线程的亲和性
+        if (::sched_setaffinity(0, sizeof(set), &set) != 0)
+            std::cerr << "[config] cpu_affinity failed: " << std::strerror(errno) << "\n";
+    }
+    const int intra = y["intra_op_threads"] ? y["intra_op_threads"].as<int>() : 0;
+    const int inter = y["inter_op_threads"] ? y["inter_op_threads"].as<int>() : 0;
+    if (intra > 0) torch::set_num_threads(intra);
+    if (inter > 0) at::set_num_interop_threads(inter);
+}
 
 // ------------ 训练 ------------
-void train_loop(const SACConfig& sac, const YAML::Node& y, bool resume) {
+int train_loop(const SACConfig& sac, const YAML::Node& y, bool resume) {
     struct TrainCfg {
         int total_steps=150000, start_steps=1000, max_ep_len=200;
         int eval_interval=5000, eval_episodes=5, seed=0, env_seed_base=123;
+        int mem_log_interval=5000; bool mem_debug_allocs=false;
+        bool async_eval=false; int metrics_port=0;
     } tr;
     tr.total_steps   = y["total_steps"]   ? y["total_steps"].as<int>()   : 150000;
     tr.start_steps   = y["start_steps"]   ? y["start_steps"].as<int>()   : 1000;
@@ -44,10 +122,19 @@ void train_loop(const SACConfig& sac, const YAML::Node& y, bool resume) {
     tr.eval_episodes = y["eval_episodes"] ? y["eval_episodes"].as<int>(): 5;
     tr.seed          = y["seed"]          ? y["seed"].as<int>()          : 0;
     tr.env_seed_base = y["env_seed_base"] ? y["env_seed_base"].as<int>() : 123;
+    tr.mem_log_interval = y["mem_log_interval"] ? y["mem_log_interval"].as<int>()  : 5000;
+    tr.mem_debug_allocs = y["mem_debug_allocs"] ? y["mem_debug_allocs"].as<bool>() : false;
+    tr.async_eval       = y["async_eval"]       ? y["async_eval"].as<bool>()       : false;
+    tr.metrics_port     = y["metrics_port"]     ? y["metrics_port"].as<int>()      : 0;
 
     torch::manual_seed(tr.seed);
     torch::Device device(torch::kCPU);
 
+    // 分配器 tracker 只在 mem_debug_allocs 时安装（会给每次 CPU 分配加上 c10 的全局锁与哈希表更新）；
+    // 在创建网络前安装，参数/优化器分配也会被计入
+    TorchAllocTrackerScope alloc_scope(tr.mem_debug_allocs);
+    TorchAllocTracker* alloc = alloc_scope.get();
+
     // 目录 / 状态文件
     const std::string ckpt_dir   = "checkpoints";
     const std::string state_path = ckpt_dir + "/state.json";
@@ -75,90 +162,207 @@ void train_loop(const SACConfig& sac, const YAML::Node& y, bool resume) {
         }
     }
 
-    ReplayBuffer buf(1'000'000, sac.obs_dim, sac.act_dim);
+    ReplayBuffer buf(1'000'000, sac.obs_dim, sac.act_dim, replay_dtype_from(y));
     CSVLogger train_log("logs/train.csv", {"step", "episode_return"}, /*append=*/resume);
     CSVLogger eval_log("logs/eval.csv",   {"step", "avg_return", "alpha"}, /*append=*/resume);
+    CSVLogger mem_log("logs/mem.csv", {"step", "rss_bytes", "peak_rss_bytes", "replay_bytes",
+                                       "param_bytes", "adam_bytes", "torch_live_bytes",
+                                       "torch_peak_bytes", "allocs_per_update", "alloc_bytes_per_update"},
+                      /*append=*/resume);
+    uint64_t upd_allocs = 0, upd_alloc_bytes = 0;  // mem_debug_allocs：update() 内的累计分配
+    long     upd_calls  = 0;
+    auto log_memory = [&]() {
+        const double per_upd   = upd_calls > 0 ? (double)upd_allocs / upd_calls : 0.0;
+        const double bytes_upd = upd_calls > 0 ? (double)upd_alloc_bytes / upd_calls : 0.0;
+        const size_t rss = process_rss_bytes(), peak = process_peak_rss_bytes();
+        const size_t replay = buf.memory_bytes(), params = agent.parameter_bytes(),
+                     adam = agent.optimizer_state_bytes();
+        const size_t live = alloc ? alloc->live_bytes() : 0, tpeak = alloc ? alloc->peak_bytes() : 0;
+        std::cout << "[mem] step=" << steps << " rss=" << rss / 1048576.0 << "MB"
+                  << " peak_rss=" << peak / 1048576.0 << "MB"
+                  << " replay=" << replay / 1048576.0 << "MB"
+                  << " params=" << params / 1048576.0 << "MB"
+                  << " adam=" << adam / 1048576.0 << "MB";
+        if (alloc)
+            std::cout << " torch_live=" << live / 1048576.0 << "MB"
+                      << " torch_peak=" << tpeak / 1048576.0 << "MB"
+                      << " allocs/update=" << per_upd;
+        std::cout << "\n";
+        mem_log.write_row({(double)steps, (double)rss, (double)peak, (double)replay, (double)params,
+                           (double)adam, (double)live, (double)tpeak, per_upd, bytes_upd});
+        mem_log.flush();
+        upd_allocs = upd_alloc_bytes = 0; upd_calls = 0;
+    };
+
+    // 可选：把采集到的 transition 录制成离线数据集（供 --mode offline 使用）
+    // --resume 时接着已有文件追加，不覆盖之前录制的数据
+    std::unique_ptr<OfflineDatasetWriter> recorder;
+    if (y["dataset_out"]) {
+        try {
+            recorder = std::make_unique<OfflineDatasetWriter>(y["dataset_out"].as<std::string>(),
+                                                              sac.obs_dim, sac.act_dim, 65536, /*append=*/resume);
+        } catch (const std::exception& e) {
+            std::cerr << "[dataset] " << e.what() << "\n";
+            return 1;
+        }
+        if (recorder->count() > 0)
+            std::cout << "[dataset] appending to " << y["dataset_out"].as<std::string>()
+                      << " (" << recorder->count() << " records)\n";
+    }
 
     std::mt19937 rng(tr.seed);
     std::uniform_real_distribution<double> uni_action(-sac.act_limit, sac.act_limit);
 
-    auto to_tensor = [](const std::array<double,3>& s) {
-        return torch::tensor({(float)s[0], (float)s[1], (float)s[2]}, torch::kFloat32);
-    };
-
     int ep_len = 0;
     double ep_ret = 0.0;
+    double update_sec = 0.0;   // 自上次评估以来 update() 的累计耗时
+    long   update_cnt = 0;
+    // 评估结果处理：eval.csv、best-model 保存、state.json。
+    // 同步模式在训练线程调用；async_eval 模式只在评估线程调用。
+    auto handle_eval = [&](long at_step, double avg, double alpha, const std::function<void()>& save_best) {
+        eval_log.write_row({(double)at_step, avg, alpha});
+        TrainMetrics::set(metrics().last_eval_return, avg);
+        TrainMetrics::set(metrics().last_eval_step, at_step);
+        if (avg > best_eval) {
+            best_eval = avg;
+            std::cout << "[checkpoint] new best avg_return=" << best_eval << " (step=" << at_step << ")\n";
+            save_best();
+            TrainMetrics::set(metrics().last_checkpoint_unix,
+                              std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count());
+        }
+
+        // 刷新运行状态
+        TrainState st;
+        st.global_step    = at_step;
+        st.best_eval      = best_eval;
+        st.seed           = tr.seed;
+        st.env_seed_base  = tr.env_seed_base;
+        st.last_update_iso= iso8601_now();
+        save_train_state(state_path, st);
+        eval_log.flush();
+    };
+
+    // 后台评估：在快照上评估，best-model 保存快照权重
+    std::unique_ptr<AsyncEvaluator> evaluator;
+    if (tr.async_eval) {
+        evaluator = std::make_unique<AsyncEvaluator>(
+            [&, env = PendulumEnv()](const AgentSnapshot& snap) mutable {
+                return run_eval_episodes([&](const torch::Tensor& s) {
+                    return (snap.actor->act_deterministic(s.unsqueeze(0)) * sac.act_limit).item<double>();
+                }, env, tr.eval_episodes, tr.max_ep_len);
+            },
+            [&](const EvalJob& job, double avg) {
+                std::cout << "[eval] step=" << job.step << " avg_return=" << avg
+                          << " alpha=" << job.snap.alpha() << " (async)\n";
+                handle_eval(job.step, avg, job.snap.alpha(),
+                            [&] { SACAgent::save_snapshot(job.snap, ckpt_dir); });
+            },
+            alloc_scope.make_worker_tracker());   // 评估线程的分配不计入 allocs_per_update
+    }
+
+    // 指标导出（metrics_port > 0 时在 127.0.0.1 上提供 Prometheus /metrics）
+    TrainMetrics& m = metrics();
+    MetricsServer metrics_server;
+    if (tr.metrics_port > 0) metrics_server.start(tr.metrics_port);
+    auto rate_t0 = std::chrono::steady_clock::now();
+    uint64_t rate_upd0 = m.updates_total.load(std::memory_order_relaxed);
+
     auto s_arr = env.reset(tr.env_seed_base + (int)steps); // 接上步数播种更平滑
-    auto s = to_tensor(s_arr);
+    auto s = obs_to_tensor(s_arr);
 
     while (steps < tr.total_steps) {
         // 动作：warmup 随机 / SAC
-        double a_scalar = (steps < tr.start_steps) ? uni_action(rng) : agent.select_action_train(s);
+        double a_scalar;
+        {
+            ScopedPhase ph(Phase::kAct);
+            a_scalar = (steps < tr.start_steps) ? uni_action(rng) : agent.select_action_train(s);
+        }
 
         // 环境一步
-        auto out = env.step(a_scalar);
-        auto s2 = to_tensor(out.state);
+        StepResult out;
+        {
+            ScopedPhase ph(Phase::kEnvStep);
+            out = env.step(a_scalar);
+        }
+        auto s2 = obs_to_tensor(out.state);
 
         // 存入 buffer（动作是真实尺度）
-        buf.push(s,
-                 torch::tensor({(float)a_scalar}, torch::kFloat32),
-                 torch::tensor({(float)out.reward}, torch::kFloat32),
-                 s2,
-                 torch::tensor({0.0f}, torch::kFloat32));
+        float a_f = (float)a_scalar;
+        buf.push(s.data_ptr<float>(), &a_f, (float)out.reward, s2.data_ptr<float>(), 0.0f);
+        if (recorder)
+            recorder->write(s.data_ptr<float>(), &a_f, (float)out.reward, s2.data_ptr<float>(), 0.0f);
 
         // 推进
         s = s2; ep_ret += out.reward; ep_len++; steps++;
 
         // 更新
-        if (buf.size() >= (size_t)sac.batch_size)
+        if (buf.size() >= (size_t)sac.batch_size) {
+            auto t0 = std::chrono::steady_clock::now();
+            const bool count = alloc != nullptr;
+            const uint64_t a0 = count ? alloc->allocs() : 0, b0 = count ? alloc->alloc_bytes() : 0;
             for (int u=0; u<sac.updates_per_step; ++u) agent.update(buf);
+            if (count) {
+                upd_allocs      += alloc->allocs() - a0;
+                upd_alloc_bytes += alloc->alloc_bytes() - b0;
+                upd_calls       += sac.updates_per_step;
+            }
+            update_sec += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            update_cnt += sac.updates_per_step;
+        }
+
+        // 指标（relaxed 原子写，不会被抓取阻塞）
+        TrainMetrics::set(m.global_step, steps);
+        TrainMetrics::set(m.replay_size, buf.size());
+        if (steps % 1000 == 0) {
+            const auto now = std::chrono::steady_clock::now();
+            const double dt = std::chrono::duration<double>(now - rate_t0).count();
+            const uint64_t upd = m.updates_total.load(std::memory_order_relaxed);
+            TrainMetrics::set(m.steps_per_sec,   1000.0 / dt);
+            TrainMetrics::set(m.updates_per_sec, (upd - rate_upd0) / dt);
+            TrainMetrics::set(m.alpha, agent.alpha());
+            rate_t0 = now; rate_upd0 = upd;
+        }
 
         // 回合截断（固定长度）
         if (ep_len >= tr.max_ep_len) {
             std::cout << "[train] step=" << steps << " ep_ret=" << ep_ret << "\n";
             train_log.write_row({(double)steps, ep_ret});
             s_arr = env.reset(tr.env_seed_base + (int)steps);
-            s = to_tensor(s_arr);
+            s = obs_to_tensor(s_arr);
             ep_len = 0; ep_ret = 0.0;
         }
 
+        // 定期内存统计
+        if (tr.mem_log_interval > 0 && steps % tr.mem_log_interval == 0) log_memory();
+
         // 定期评估（不渲染）
         if (steps % tr.eval_interval == 0) {
-            double avg = 0.0;
-            for (int e=0; e<tr.eval_episodes; ++e) {
-                auto st = to_tensor(env.reset(1000 + e));
-                double er = 0.0;
-                for (int t=0; t<tr.max_ep_len; ++t) {
-                    double a_eval = agent.select_action_eval(st);
-                    auto o2 = env.step(a_eval);
-                    er += o2.reward;
-                    st = to_tensor(o2.state);
-                }
-                avg += er;
-            }
-            avg /= tr.eval_episodes;
-            std::cout << "[eval] step=" << steps << " avg_return=" << avg << " alpha=" << agent.alpha() << "\n";
-            eval_log.write_row({(double)steps, avg, agent.alpha()});
-
-            if (avg > best_eval) {
-                best_eval = avg;
-                std::cout << "[checkpoint] new best avg_return=" << best_eval << "\n";
-                agent.save(ckpt_dir);
+            const double ups = update_sec > 0.0 ? update_cnt / update_sec : 0.0;
+            update_sec = 0.0; update_cnt = 0;
+            if (evaluator) {
+                auto t0 = std::chrono::steady_clock::now();
+                EvalJob job;
+                job.step = steps;
+                job.snap = agent.snapshot();
+                job.snapshot_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+                std::cout << "[eval] step=" << steps << " snapshot=" << job.snapshot_us << "us"
+                          << " pending=" << evaluator->pending() << " updates/sec=" << ups << "\n";
+                evaluator->submit(std::move(job));
+            } else {
+                double avg = evaluate_policy(agent, env, tr.eval_episodes, tr.max_ep_len);
+                std::cout << "[eval] step=" << steps << " avg_return=" << avg << " alpha=" << agent.alpha()
+                          << " updates/sec=" << ups << "\n";
+                handle_eval(steps, avg, agent.alpha(), [&] { agent.save(ckpt_dir); });
             }
 
-            // 刷新运行状态
-            TrainState st;
-            st.global_step    = steps;
-            st.best_eval      = best_eval;
-            st.seed           = tr.seed;
-            st.env_seed_base  = tr.env_seed_base;
-            st.last_update_iso= iso8601_now();
-            save_train_state(state_path, st);
-
-            train_log.flush(); eval_log.flush();
+            train_log.flush();
+            if (recorder) recorder->flush();
         }
     }
 
+    // 等待后台评估完成（之后 best_eval 不再变化）
+    if (evaluator) evaluator->finish();
+
     // 兜底再保存一次 state
     TrainState st_final;
     st_final.global_step    = steps;
@@ -169,19 +373,128 @@ void train_loop(const SACConfig& sac, const YAML::Node& y, bool resume) {
     save_train_state(state_path, st_final);
 
     std::cout << "Training finished.\n";
+    return 0;
+}
+
+// ------------ 离线训练（从磁盘数据集流式读入，不与环境交互） ------------
+// 返回值：0 正常；1 数据集缺失/维度不符/为空
+int offline_loop(const SACConfig& sac, const YAML::Node& y, const std::string& dataset_path) {
+    int total_updates   = y["offline_updates"]        ? y["offline_updates"].as<int>()           : 100000;
+    int ingest_per_upd  = y["offline_ingest_per_update"] ? y["offline_ingest_per_update"].as<int>() : 1;
+    size_t window       = y["offline_shuffle_window"] ? y["offline_shuffle_window"].as<size_t>() : 100000;
+    size_t capacity     = y["offline_replay_capacity"] ? y["offline_replay_capacity"].as<size_t>() : 1'000'000;
+    int eval_interval   = y["eval_interval"]  ? y["eval_interval"].as<int>()  : 5000;
+    int eval_episodes   = y["eval_episodes"]  ? y["eval_episodes"].as<int>()  : 5;
+    int max_ep_len      = y["max_ep_len"]     ? y["max_ep_len"].as<int>()     : 200;
+    int seed            = y["seed"]           ? y["seed"].as<int>()           : 0;
+
+    // 与在线训练的 checkpoints/ 分开，避免覆盖在线模型（其 state.json 的 best_eval 与之无关）
+    const std::string ckpt_dir = y["offline_ckpt_dir"] ? y["offline_ckpt_dir"].as<std::string>() : "checkpoints_offline";
+
+    torch::manual_seed(seed);
+    torch::Device device(torch::kCPU);
+    fs::create_directories(ckpt_dir);
+
+    std::unique_ptr<OfflineDatasetReader> reader;
+    try {
+        reader = std::make_unique<OfflineDatasetReader>(dataset_path);
+    } catch (const std::exception& e) {
+        std::cerr << "[offline] " << e.what() << "\n";
+        return 1;
+    }
+    if (reader->obs_dim() != sac.obs_dim || reader->act_dim() != sac.act_dim) {
+        std::cerr << "[offline] dataset dims " << reader->obs_dim() << "/" << reader->act_dim()
+                  << " do not match config " << sac.obs_dim << "/" << sac.act_dim << "\n";
+        return 1;
+    }
+    if (reader->records() == 0) {
+        std::cerr << "[offline] empty dataset " << dataset_path << "\n";
+        return 1;
+    }
+    std::cout << "[offline] dataset=" << dataset_path << " records=" << reader->records()
+              << " shuffle_window=" << window << "\n";
+
+    PendulumEnv env;
+    SACAgent agent(sac, device);
+    ReplayBuffer buf(capacity, sac.obs_dim, sac.act_dim, replay_dtype_from(y));
+    CSVLogger eval_log("logs/offline_eval.csv", {"step", "avg_return", "alpha"});
+    ShuffleWindow shuffler(*reader, window, (unsigned)seed);
+
+    const int od = sac.obs_dim, ad = sac.act_dim;
+    std::vector<float> row(reader->row_floats());
+    long   ingested = 0;
+    int    epoch = 0;
+    double ingest_sec = 0.0;
+    double best_eval = -1e9;
+
+    // 读一条记录并压入回放；一轮读完后从头开始下一轮
+    auto ingest_one = [&]() -> bool {
+        if (!shuffler.next(row.data())) {
+            reader->rewind();
+            ++epoch;
+            if (!shuffler.next(row.data())) return false;
+        }
+        const float* p = row.data();
+        buf.push(p, p + od, p[od + ad], p + od + ad + 1, p[2*od + ad + 1]);
+        ++ingested;
+        return true;
+    };
+
+    using clock = std::chrono::steady_clock;
+    long updates = 0;
+    while (updates < total_updates) {
+        auto t0 = clock::now();
+        for (int k=0; k<ingest_per_upd; ++k)
+            if (!ingest_one()) { std::cerr << "[offline] empty dataset\n"; return 1; }
+        // 回放未够一个 batch 前只读不训
+        while (buf.size() < (size_t)sac.batch_size && ingest_one()) {}
+        ingest_sec += std::chrono::duration<double>(clock::now() - t0).count();
+
+        agent.update(buf);
+        ++updates;
+
+        if (updates % eval_interval == 0) {
+            double avg = evaluate_policy(agent, env, eval_episodes, max_ep_len);
+            std::cout << "[offline] updates=" << updates << " epoch=" << epoch
+                      << " avg_return=" << avg << " alpha=" << agent.alpha()
+                      << " ingest=" << (ingest_sec > 0.0 ? ingested / ingest_sec : 0.0) << " transitions/sec\n";
+            eval_log.write_row({(double)updates, avg, agent.alpha()});
+            eval_log.flush();
+            if (avg > best_eval) {
+                best_eval = avg;
+                std::cout << "[checkpoint] new best avg_return=" << best_eval << " -> " << ckpt_dir << "\n";
+                agent.save(ckpt_dir);
+            }
+        }
+    }
+    std::cout << "[offline] finished: updates=" << updates << " ingested=" << ingested
+              << " ingest=" << (ingest_sec > 0.0 ? ingested / ingest_sec : 0.0) << " transitions/sec\n";
+    return 0;
 }
 
 // ------------ 评估（默认渲染） ------------
-void eval_loop(const SACConfig& sac, const YAML::Node& y) {
+void eval_loop(const SACConfig& sac, const YAML::Node& y, const std::string& student_dir) {
     int eval_episodes = y["eval_episodes"] ? y["eval_episodes"].as<int>() : 5;
     int max_ep_len    = y["max_ep_len"]    ? y["max_ep_len"].as<int>()    : 200;
 
     torch::Device device(torch::kCPU);
     SACAgent agent(sac, device);
-    if (!agent.load("checkpoints", device)) {
+    StudentPolicy student{nullptr};
+    double student_act_limit = sac.act_limit;
+    if (!student_dir.empty()) {
+        // 评估蒸馏得到的学生网络
+        if (!load_student(student_dir, student, student_act_limit)) return;
+        std::cout << "[eval] student " << student_dir << ": width=" << student->width
+                  << " depth=" << student->depth << "\n";
+    } else if (!agent.load("checkpoints", device)) {
         std::cerr << "[eval] No checkpoint found in ./checkpoints\n";
         return;
     }
+    torch::NoGradGuard ng;
+    auto act = [&](const torch::Tensor& s) {
+        if (student) return student->forward(s.unsqueeze(0)).item<double>() * student_act_limit;
+        return agent.select_action_eval(s);
+    };
 
     // 读取 state.json 仅用于提示
     if (auto st = load_train_state("checkpoints/state.json")) {
@@ -193,19 +506,15 @@ void eval_loop(const SACConfig& sac, const YAML::Node& y) {
     PendulumEnv env;
     PendulumRenderer renderer(600, 600, 200);
 
-    auto to_tensor = [](const std::array<double,3>& s) {
-        return torch::tensor({(float)s[0], (float)s[1], (float)s[2]}, torch::kFloat32);
-    };
-
     for (int e=0; e<eval_episodes; ++e) {
         auto s_arr = env.reset(2000 + e);
-        auto s = to_tensor(s_arr);
+        auto s = obs_to_tensor(s_arr);
         double ep_ret = 0.0;
         for (int t=0; t<max_ep_len; ++t) {
-            double a_eval = agent.select_action_eval(s);
+            double a_eval = act(s);
             auto out = env.step(a_eval);
             ep_ret += out.reward;
-            s = to_tensor(out.state);
+            s = obs_to_tensor(out.state);
 
             // 始终渲染（按 q 可关闭窗口）
             if (!renderer.is_closed())
@@ -219,11 +528,723 @@ void eval_loop(const SACConfig& sac, const YAML::Node& y) {
 
 }
 
+// ------------ 策略蒸馏：把 teacher 的确定性策略压缩进小网络 ------------
+int distill_loop(const SACConfig& sac, const YAML::Node& y) {
+    using clock = std::chrono::steady_clock;
+    using json = nlohmann::json;
+    const int rollout_steps = y["distill_rollout_steps"] ? y["distill_rollout_steps"].as<int>()    : 50000;
+    const int epochs        = y["distill_epochs"]        ? y["distill_epochs"].as<int>()           : 30;
+    const int batch         = y["distill_batch"]         ? y["distill_batch"].as<int>()            : 256;
+    const double lr         = y["distill_lr"]            ? y["distill_lr"].as<double>()            : 1e-3;
+    const std::string out_dir = y["distill_out"]         ? y["distill_out"].as<std::string>()      : "checkpoints/students";
+    const std::string dataset = y["distill_dataset"]     ? y["distill_dataset"].as<std::string>()  : "";
+    const long dataset_max  = y["distill_dataset_max_states"] ? y["distill_dataset_max_states"].as<long>() : 200000;
+    const int eval_episodes = y["eval_episodes"]         ? y["eval_episodes"].as<int>()            : 5;
+    const int max_ep_len    = y["max_ep_len"]            ? y["max_ep_len"].as<int>()               : 200;
+    std::vector<std::pair<int,int>> sizes = {{16, 1}, {32, 1}, {32, 2}, {64, 2}};  // (width, depth)
+    if (y["distill_sizes"]) {
+        sizes.clear();
+        for (const auto& n : y["distill_sizes"]) sizes.emplace_back(n[0].as<int>(), n[1].as<int>());
+    }
+
+    if (rollout_steps <= 0 && (dataset.empty() || dataset_max <= 0)) {
+        std::cerr << "[distill] no states: set distill_rollout_steps > 0 or distill_dataset\n";
+        return 1;
+    }
+
+    torch::manual_seed(0);
+    torch::Device device(torch::kCPU);
+    fs::create_directories(out_dir);
+    SACAgent teacher(sac, device);
+    if (!teacher.load("checkpoints", device)) {
+        std::cerr << "[distill] No teacher checkpoint found in ./checkpoints\n";
+        return 1;
+    }
+
+    // 1) 采集状态：teacher 随机策略 rollout（覆盖更宽的状态分布）+ 可选离线数据集中的 s
+    std::vector<float> states;
+    PendulumEnv env;
+    {
+        auto s_arr = env.reset(5000);
+        for (int t=0, ep_len=0; t<rollout_steps; ++t) {
+            auto s = obs_to_tensor(s_arr);
+            states.insert(states.end(), s.data_ptr<float>(), s.data_ptr<float>() + sac.obs_dim);
+            s_arr = env.step(teacher.select_action_train(s)).state;
+            if (++ep_len >= max_ep_len) { s_arr = env.reset(5000 + t); ep_len = 0; }
+        }
+    }
+    // 数据集可能大于内存：流式读取，蓄水池抽样至多 dataset_max 个状态
+    if (!dataset.empty() && dataset_max > 0) {
+        try {
+            OfflineDatasetReader reader(dataset);
+            const size_t od = (size_t)sac.obs_dim, base = states.size();
+            std::mt19937_64 rng(0);
+            long seen = 0;
+            while (const float* row = reader.next()) {
+                if (seen < dataset_max) {
+                    states.insert(states.end(), row, row + od);
+                } else {
+                    const long j = std::uniform_int_distribution<long>(0, seen)(rng);
+                    if (j < dataset_max) std::copy(row, row + od, states.begin() + base + (size_t)j * od);
+                }
+                ++seen;
+            }
+            std::cout << "[distill] dataset " << dataset << ": sampled " << std::min(seen, dataset_max)
+                      << " of " << seen << " states\n";
+        } catch (const std::exception& e) {
+            std::cerr << "[distill] skip dataset: " << e.what() << "\n";
+        }
+    }
+    const long N = (long)(states.size() / sac.obs_dim);
+    if (N == 0) {
+        std::cerr << "[distill] no states collected\n";
+        return 1;
+    }
+    auto S = torch::from_blob(states.data(), {N, sac.obs_dim}, torch::kFloat32).clone();
+    torch::Tensor T;
+    {
+        torch::NoGradGuard ng;
+        T = teacher.actor()->act_deterministic(S);   // [-1,1]
+    }
+    std::cout << "[distill] states=" << N << "\n";
+
+    // 2) teacher 基准：回报与单步延迟（libtorch / 扁平运行时）
+    auto time_us = [](auto&& fn, int n) {
+        auto t0 = clock::now();
+        for (int i=0; i<n; ++i) fn(i);
+        return std::chrono::duration<double, std::micro>(clock::now() - t0).count() / n;
+    };
+    const int lat_n = std::min<long>(N, 5000);
+    // 计时前准备好输入：libtorch 路径用预先切好的 [1,obs_dim] 行，扁平路径直接用原始指针，
+    // 避免把每次 S[i] 的 select/TensorImpl 分配算进推理延迟
+    std::vector<torch::Tensor> lat_rows;
+    lat_rows.reserve(lat_n);
+    for (int i=0; i<lat_n; ++i) lat_rows.push_back(S.narrow(0, i, 1));
+    const float* lat_ptr = S.data_ptr<float>();
+    const size_t od = (size_t)sac.obs_dim;
+    const double teacher_ret = evaluate_policy(teacher, env, eval_episodes, max_ep_len);
+    // teacher 与学生的 libtorch 计时口径一致：NoGradGuard 下前向，乘 act_limit 后取 .item()
+    double teacher_torch_us = 0.0;
+    {
+        torch::NoGradGuard ng;
+        teacher_torch_us = time_us([&](int i) {
+            (void)(teacher.actor()->act_deterministic(lat_rows[i]) * sac.act_limit).item<double>();
+        }, lat_n);
+    }
+    double teacher_flat_us = 0.0;
+    {
+        const std::string p = (fs::path(out_dir) / "teacher.bin").string();
+        flat_policy::Policy fp;
+        if (teacher.export_policy(p) && fp.load(p))
+            teacher_flat_us = time_us([&](int i) { fp.act1(lat_ptr + (size_t)i * od); }, lat_n);
+    }
+
+    json report = {{"teacher", {{"return", teacher_ret}, {"torch_us", teacher_torch_us}, {"flat_us", teacher_flat_us}}},
+                   {"students", json::array()}};
+    std::cout << "[distill] teacher: return=" << teacher_ret << " torch=" << teacher_torch_us
+              << "us flat=" << teacher_flat_us << "us\n";
+
+    // 3) 逐个尺寸训练学生（MSE 模仿 act_deterministic）
+    for (const auto& [width, depth] : sizes) {
+        torch::manual_seed(0);
+        StudentPolicy student(sac.obs_dim, width, depth, sac.act_dim);
+        torch::optim::Adam opt(student->parameters(), torch::optim::AdamOptions(lr));
+        double loss_v = 0.0;
+        for (int ep=0; ep<epochs; ++ep) {
+            auto perm = torch::randperm(N, torch::kInt64);
+            double sum = 0.0; long nb = 0;
+            for (long i=0; i<N; i+=batch) {
+                auto idx = perm.slice(0, i, std::min<long>(i + batch, N));
+                auto loss = torch::mse_loss(student->forward(S.index_select(0, idx)), T.index_select(0, idx));
+                opt.zero_grad();
+                loss.backward();
+                opt.step();
+                sum += loss.item<double>(); nb++;
+            }
+            loss_v = sum / std::max<long>(1, nb);
+        }
+
+        torch::NoGradGuard ng;
+        const double ret = run_eval_episodes([&](const torch::Tensor& s) {
+            return student->forward(s.unsqueeze(0)).item<double>() * sac.act_limit;
+        }, env, eval_episodes, max_ep_len);
+
+        const std::string dir = (fs::path(out_dir) / ("w" + std::to_string(width) + "_d" + std::to_string(depth))).string();
+        save_student(student, sac.act_limit, dir);
+        const double torch_us = time_us([&](int i) {
+            (void)(student->forward(lat_rows[i]) * sac.act_limit).item<double>();
+        }, lat_n);
+        double flat_us = 0.0;
+        flat_policy::Policy fp;
+        if (fp.load((fs::path(dir) / "student.bin").string()))
+            flat_us = time_us([&](int i) { fp.act1(lat_ptr + (size_t)i * od); }, lat_n);
+
+        std::cout << "[distill] width=" << width << " depth=" << depth << " mse=" << loss_v
+                  << " return=" << ret << " (teacher " << teacher_ret << ")"
+                  << " torch=" << torch_us << "us flat=" << flat_us << "us -> " << dir << "\n";
+        report["students"].push_back({{"width", width}, {"depth", depth}, {"mse", loss_v},
+                                      {"return", ret}, {"torch_us", torch_us}, {"flat_us", flat_us},
+                                      {"dir", dir}});
+    }
+
+    std::ofstream(fs::path(out_dir) / "distill_report.json") << report.dump(2) << std::endl;
+    std::cout << "[distill] report written to " << (fs::path(out_dir) / "distill_report.json").string() << "\n";
+    return 0;
+}
+
+// ------------ 导出扁平策略（供 policy_runtime 使用） ------------
+int export_loop(const SACConfig& sac, const std::string& out_path) {
+    using clock = std::chrono::steady_clock;
+    torch::Device device(torch::kCPU);
+    SACAgent agent(sac, device);
+    if (!agent.load("checkpoints", device)) {
+        std::cerr << "[export] No checkpoint found in ./checkpoints\n";
+        return 1;
+    }
+    // libtorch 路径的冷启动：进程创建（含 exec 与 libtorch 动态链接）到第一个动作，与 policy_runtime 同口径
+    {
+        PendulumEnv env0;
+        (void)agent.select_action_eval(obs_to_tensor(env0.reset(2000)));
+    }
+    const double torch_first_action_us = process_age_us();
+    if (!agent.export_policy(out_path)) return 1;
+
+    // 校验：随机状态 + 评估轨迹上的状态，对比 Actor::act_deterministic
+    flat_policy::Policy policy;
+    std::string err;
+    auto t0 = clock::now();
+    if (!policy.load(out_path, &err)) {
+        std::cerr << "[export] reload failed: " << err << "\n";
+        return 1;
+    }
+    double load_us = std::chrono::duration<double, std::micro>(clock::now() - t0).count();
+
+    torch::NoGradGuard ng;
+    torch::manual_seed(0);
+    auto theta = torch::rand({4096}) * (2.0 * M_PI) - M_PI;
+    auto thdot = torch::rand({4096}) * 16.0 - 8.0;
+    std::vector<torch::Tensor> rows = {torch::stack({torch::cos(theta), torch::sin(theta), thdot}, 1)};
+    PendulumEnv env;
+    for (int e=0; e<5; ++e) {
+        auto s_arr = env.reset(2000 + e);
+        for (int t=0; t<200; ++t) {
+            auto st = obs_to_tensor(s_arr);
+            rows.push_back(st.unsqueeze(0));
+            s_arr = env.step(agent.select_action_eval(st)).state;
+        }
+    }
+    auto S = torch::cat(rows, 0).to(torch::kFloat32).contiguous();
+    auto ref = (agent.actor()->act_deterministic(S) * sac.act_limit).contiguous();
+
+    const float* sp = S.data_ptr<float>();
+    const float* rp = ref.data_ptr<float>();
+    double max_err = 0.0;
+    for (int64_t i=0; i<S.size(0); ++i)
+        max_err = std::max(max_err, std::abs(policy.act1(sp + i * sac.obs_dim) - (double)rp[i]));
+
+    std::cout << "[export] validated " << S.size(0) << " states, max_abs_err=" << max_err
+              << " (tol 1e-5), reload=" << load_us << "us"
+              << " torch_first_action=" << torch_first_action_us << "us since process start"
+              << " weights=" << policy.file_bytes() << "B"
+              << " exe=" << self_exe_bytes() << "B"
+              << " shared_libs=" << mapped_library_bytes() << "B\n";
+    if (max_err > 1e-5) {
+        std::cerr << "[export] runtime mismatch exceeds tolerance\n";
+        return 1;
+    }
+    return 0;
+}
+
+// ------------ 吞吐基准（固定种子工作负载 + 基线回归检查） ------------
+// 返回值：0 正常；1 运行/读取错误或工作负载与基线不一致；2 相对基线出现性能回归
+int bench_loop(const SACConfig& sac, const YAML::Node& y,
+               const std::string& baseline_path, bool write_baseline, const std::string& out_path) {
+    using clock = std::chrono::steady_clock;
+    using json = nlohmann::json;
+    auto sec = [](clock::duration d) { return std::chrono::duration<double>(d).count(); };
+
+    const int warmup_steps  = y["bench_warmup_steps"]  ? y["bench_warmup_steps"].as<int>()  : 1000;
+    const int bench_steps   = y["bench_steps"]         ? y["bench_steps"].as<int>()         : 5000;
+    const int eval_episodes = y["bench_eval_episodes"] ? y["bench_eval_episodes"].as<int>() : 10;
+    const int max_ep_len    = y["max_ep_len"]          ? y["max_ep_len"].as<int>()          : 200;
+    const double threshold  = y["bench_threshold"]     ? y["bench_threshold"].as<double>()  : 0.10;
+    const int seed = 0;
+
+    torch::manual_seed(seed);
+    torch::Device device(torch::kCPU);
+    PendulumEnv env;
+    SACAgent agent(sac, device);
+    ReplayBuffer buf((size_t)(warmup_steps + bench_steps), sac.obs_dim, sac.act_dim, replay_dtype_from(y));
+
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> uni_action(-sac.act_limit, sac.act_limit);
+
+    auto s = obs_to_tensor(env.reset(123));
+    int ep_len = 0;
+    auto env_step = [&](double a) {
+        auto out = env.step(a);
+        auto s2 = obs_to_tensor(out.state);
+        float a_f = (float)a;
+        buf.push(s.data_ptr<float>(), &a_f, (float)out.reward, s2.data_ptr<float>(), 0.0f);
+        s = s2;
+        if (++ep_len >= max_ep_len) { s = obs_to_tensor(env.reset(123 + (int)buf.size())); ep_len = 0; }
+    };
+
+    // 1) warmup：随机动作填充回放，不更新
+    for (int i=0; i<warmup_steps; ++i) env_step(uni_action(rng));
+
+    // 2) 采集 + 更新
+    double update_sec = 0.0;
+    long   updates = 0;
+    auto t0 = clock::now();
+    for (int i=0; i<bench_steps; ++i) {
+        env_step(agent.select_action_train(s));
+        if (buf.size() >= (size_t)sac.batch_size) {
+            auto tu = clock::now();
+            for (int u=0; u<sac.updates_per_step; ++u) agent.update(buf);
+            update_sec += sec(clock::now() - tu);
+            updates += sac.updates_per_step;
+        }
+    }
+    const double train_sec = sec(clock::now() - t0);
+
+    // 3) 评估
+    auto te = clock::now();
+    double eval_ret = evaluate_policy(agent, env, eval_episodes, max_ep_len);
+    const double eval_sec = sec(clock::now() - te);
+
+    json cur = {
+        {"env_steps_per_sec", bench_steps / train_sec},
+        {"updates_per_sec",   update_sec > 0.0 ? updates / update_sec : 0.0},
+        {"eval_episode_ms",   1e3 * eval_sec / std::max(1, eval_episodes)},
+        {"eval_action_us",    1e6 * eval_sec / std::max(1, eval_episodes * max_ep_len)},
+        {"peak_rss_bytes",    (double)process_peak_rss_bytes()},
+        {"eval_return",       eval_ret},
+        {"workload", {
+            {"warmup_steps", warmup_steps}, {"bench_steps", bench_steps},
+            {"eval_episodes", eval_episodes}, {"hidden", sac.hidden},
+            {"batch_size", sac.batch_size}, {"updates_per_step", sac.updates_per_step},
+            {"critic_split", sac.critic_split}, {"autocast_bf16", sac.autocast_bf16},
+            {"torch_threads", torch::get_num_threads()},
+            {"interop_threads", at::get_num_interop_threads()}
+        }}
+    };
+    std::cout << cur.dump(2) << std::endl;
+    if (!out_path.empty()) {
+        std::ofstream out(out_path);
+        out << cur.dump(2) << std::endl;
+    }
+
+    if (write_baseline) {
+        const auto parent = fs::path(baseline_path).parent_path();
+        if (!parent.empty()) fs::create_directories(parent);
+        std::ofstream out(baseline_path);
+        if (!out.is_open()) { std::cerr << "[bench] cannot write " << baseline_path << "\n"; return 1; }
+        out << cur.dump(2) << std::endl;
+        std::cout << "[bench] baseline written to " << baseline_path << "\n";
+        return 0;
+    }
+
+    std::ifstream in(baseline_path);
+    if (!in.is_open()) {
+        std::cout << "[bench] no baseline at " << baseline_path << ", skip comparison\n";
+        return 0;
+    }
+    json base;
+    try { in >> base; } catch (...) {
+        std::cerr << "[bench] cannot parse baseline " << baseline_path << "\n";
+        return 1;
+    }
+
+    // 工作负载不同（网络尺寸、batch、线程数、步数……）时数字不可比，拒绝比较
+    if (!base.contains("workload")) {
+        std::cerr << "[bench] WARNING: baseline has no workload section, cannot verify it is comparable\n";
+    } else if (base["workload"] != cur["workload"]) {
+        std::cerr << "[bench] workload differs from baseline, refusing to compare:\n";
+        for (const auto& [k, v] : cur["workload"].items()) {
+            const json b = base["workload"].contains(k) ? base["workload"][k] : json();
+            if (b != v) std::cerr << "[bench]   " << k << ": baseline=" << b.dump() << " current=" << v.dump() << "\n";
+        }
+        for (const auto& [k, v] : base["workload"].items())
+            if (!cur["workload"].contains(k))
+                std::cerr << "[bench]   " << k << ": baseline=" << v.dump() << " current=<missing>\n";
+        std::cerr << "[bench] re-run with matching config or regenerate with --write-baseline\n";
+        return 1;
+    }
+
+    // 指标方向：true 表示越大越好
+    const std::vector<std::pair<std::string, bool>> metrics = {
+        {"env_steps_per_sec", true}, {"updates_per_sec", true},
+        {"eval_episode_ms", false},  {"eval_action_us", false}, {"peak_rss_bytes", false}
+    };
+    bool regressed = false;
+    for (const auto& [name, higher_better] : metrics) {
+        if (!base.contains(name) || !cur.contains(name)) continue;
+        const double b = base[name].get<double>(), c = cur[name].get<double>();
+        if (b <= 0.0) continue;
+        const double change = higher_better ? (b - c) / b : (c - b) / b;  // >0 表示变差
+        const bool bad = change > threshold;
+        regressed |= bad;
+        std::cout << "[bench] " << name << ": baseline=" << b << " current=" << c
+                  << " change=" << (higher_better ? (c - b) / b : (b - c) / b) * 100.0 << "%"
+                  << (bad ? "  REGRESSION" : "") << "\n";
+    }
+    if (regressed) {
+        std::cerr << "[bench] regression beyond threshold " << threshold * 100.0 << "%\n";
+        return 2;
+    }
+    std::cout << "[bench] within threshold " << threshold * 100.0 << "%\n";
+    return 0;
+}
+
+// ------------ 固定周期实时控制回路（扁平策略 + 绝对时刻睡眠） ------------
+// 返回值：0 正常；1 加载/初始化错误；2 超出时间预算（deadline miss 或计算延迟 p99 超标）
+int realtime_loop(const SACConfig& sac, const YAML::Node& y, const std::string& policy_path) {
+    using json = nlohmann::json;
+    const double hz          = y["realtime_hz"]          ? y["realtime_hz"].as<double>()          : 20.0;
+    const double duration_s  = y["realtime_duration_s"]  ? y["realtime_duration_s"].as<double>()  : 30.0;
+    const std::string plant  = y["realtime_plant"]       ? y["realtime_plant"].as<std::string>()  : "env";
+    const int udp_port       = y["realtime_udp_port"]    ? y["realtime_udp_port"].as<int>()       : 47001;
+    const int cpu            = y["realtime_cpu"]         ? y["realtime_cpu"].as<int>()            : -1;
+    const int priority       = y["realtime_priority"]    ? y["realtime_priority"].as<int>()       : 0;
+    const bool lock_memory   = y["realtime_mlock"]       ? y["realtime_mlock"].as<bool>()         : false;
+    const double bin_us      = y["realtime_hist_bin_us"] ? y["realtime_hist_bin_us"].as<double>() : 1.0;
+    const double budget_us   = y["realtime_budget_us"]   ? y["realtime_budget_us"].as<double>()   : 0.0;
+    const long max_misses    = y["realtime_max_misses"]  ? y["realtime_max_misses"].as<long>()    : 0;
+    const int ep_len         = y["max_ep_len"]           ? y["max_ep_len"].as<int>()              : 200;
+
+    if (hz <= 0.0 || (plant != "env" && plant != "udp")) {
+        std::cerr << "[realtime] need realtime_hz > 0 and realtime_plant env|udp\n";
+        return 1;
+    }
+
+    // 1) 策略：扁平权重文件；不存在时从 checkpoints 导出
+    if (!fs::exists(policy_path)) {
+        SACAgent agent(sac, torch::kCPU);
+        if (!agent.load("checkpoints", torch::kCPU) || !agent.export_policy(policy_path)) {
+            std::cerr << "[realtime] no policy at " << policy_path << " and cannot export from ./checkpoints\n";
+            return 1;
+        }
+    }
+    flat_policy::Policy policy;
+    std::string err;
+    if (!policy.load(policy_path, &err)) {
+        std::cerr << "[realtime] load failed: " << err << "\n";
+        return 1;
+    }
+    if (policy.obs_dim() != 3 || policy.act_dim() != 1) {
+        std::cerr << "[realtime] expect obs_dim=3 act_dim=1, got "
+                  << policy.obs_dim() << "/" << policy.act_dim() << "\n";
+        return 1;
+    }
+
+    // 2) 线程与内存：绑核 / SCHED_FIFO / 锁页，失败只告警
+    if (cpu >= 0 && !rt::pin_current_thread(cpu, &err))
+        std::cerr << "[realtime] cannot pin to cpu " << cpu << ": " << err << "\n";
+    if (priority > 0 && !rt::set_fifo_priority(priority, &err))
+        std::cerr << "[realtime] cannot set SCHED_FIFO " << priority << ": " << err << "\n";
+    if (lock_memory && ::mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+        std::cerr << "[realtime] mlockall failed: " << std::strerror(errno) << "\n";
+
+    // 3) 被控对象
+    const int64_t period_ns = (int64_t)std::llround(1e9 / hz);
+    const bool use_udp = plant == "udp";
+    PendulumEnv env;
+    rt::UdpPlantClient udp;
+    if (use_udp && !udp.open(udp_port, &err)) {
+        std::cerr << "[realtime] cannot open udp plant: " << err << "\n";
+        return 1;
+    }
+    float obs[3], action = 0.0f, reward = 0.0f;
+    auto plant_reset = [&](uint32_t seed, int64_t deadline_ns) {
+        if (use_udp) return udp.reset(seed, obs, deadline_ns);
+        auto s = env.reset(seed);
+        for (int i=0; i<3; ++i) obs[i] = (float)s[i];
+        return true;
+    };
+    auto plant_step = [&](int64_t deadline_ns) {
+        if (use_udp) return udp.step(action, obs, &reward, deadline_ns);
+        auto out = env.step(action);
+        for (int i=0; i<3; ++i) obs[i] = (float)out.state[i];
+        reward = (float)out.reward;
+        return true;
+    };
+    if (!plant_reset(2000, rt::now_ns() + 1000000000LL)) {   // 回路外：等待对象就绪最多 1s
+        std::cerr << "[realtime] plant did not answer on udp://127.0.0.1:" << udp_port
+                  << " (start ./plant_server first)\n";
+        return 1;
+    }
+
+    // 4) 直方图在进入回路前一次性分配；量程取 2 个周期，更慢的样本进溢出桶
+    const int64_t bin_ns = std::max<int64_t>(1, (int64_t)(bin_us * 1e3));
+    const size_t bins = (size_t)(2 * period_ns / bin_ns) + 1;
+    rt::Histogram compute_h(bin_ns, bins), tick_h(bin_ns, bins), jitter_h(bin_ns, bins);
+    for (int i=0; i<100; ++i) policy.act(obs, &action);   // 预热：把权重页读入缓存
+
+    const long ticks = std::max(1L, (long)std::llround(duration_s * hz));
+    long misses = 0, skipped = 0, plant_timeouts = 0, episodes = 0;
+    double ep_ret = 0.0, ret_sum = 0.0;
+    int ep_t = 0;
+    std::cout << "[realtime] " << hz << " Hz (period " << period_ns / 1e3 << "us), " << ticks
+              << " ticks, plant=" << plant << ", policy=" << policy_path << "\n";
+
+    // 5) 回路：每拍在绝对释放时刻醒来，回路内不做堆分配与 I/O（udp 模式除外的收发）
+    int64_t release = rt::now_ns() + period_ns;
+    for (long k=0; k<ticks; ++k) {
+        rt::sleep_until_ns(release);
+        const int64_t t_wake = rt::now_ns();
+        jitter_h.record(t_wake - release);
+
+        policy.act(obs, &action);
+        const int64_t t_act = rt::now_ns();
+        compute_h.record(t_act - t_wake);
+
+        const int64_t deadline = release + period_ns;
+        if (plant_step(deadline)) ep_ret += reward;
+        else ++plant_timeouts;
+        if (++ep_t >= ep_len) {
+            ret_sum += ep_ret; ++episodes;
+            ep_ret = 0.0; ep_t = 0;
+            // 回路内的 reset 同样受本拍 deadline 约束，超时计入 plant_timeouts
+            if (!plant_reset(2000 + (uint32_t)episodes, deadline)) ++plant_timeouts;
+        }
+
+        const int64_t t_done = rt::now_ns();
+        tick_h.record(t_done - t_wake);
+        if (t_done > deadline) ++misses;
+
+        // 超期后不补拍：跳到下一个尚未过去的释放时刻
+        release = deadline;
+        while (release <= t_done) { release += period_ns; ++skipped; }
+    }
+    if (lock_memory) ::munlockall();
+
+    // 6) 报告
+    auto us = [](int64_t ns) { return ns / 1e3; };
+    auto summary = [&](const rt::Histogram& h) {
+        return json{{"mean_us", h.mean() / 1e3}, {"p50_us", us(h.percentile(0.50))},
+                    {"p90_us", us(h.percentile(0.90))}, {"p99_us", us(h.percentile(0.99))},
+                    {"p999_us", us(h.percentile(0.999))}, {"max_us", us(h.max())}};
+    };
+    auto nonzero_bins = [](const rt::Histogram& h) {
+        json arr = json::array();
+        const auto& c = h.counts();
+        for (size_t i=0; i<c.size(); ++i)
+            if (c[i]) arr.push_back({(double)i * h.bin_ns() / 1e3, c[i]});   // [桶下沿 us, 次数]
+        return arr;
+    };
+    json report = {
+        {"hz", hz}, {"period_us", us(period_ns)}, {"ticks", ticks}, {"plant", plant},
+        {"policy", policy_path}, {"cpu", cpu}, {"priority", priority},
+        {"deadline_misses", misses}, {"skipped_releases", skipped}, {"plant_timeouts", plant_timeouts},
+        {"episodes", episodes}, {"avg_return", episodes ? ret_sum / episodes : 0.0},
+        {"compute", summary(compute_h)}, {"tick", summary(tick_h)}, {"jitter", summary(jitter_h)},
+        {"histograms", {{"bin_us", bin_ns / 1e3},
+                        {"compute", nonzero_bins(compute_h)}, {"tick", nonzero_bins(tick_h)},
+                        {"jitter", nonzero_bins(jitter_h)}}}
+    };
+    fs::create_directories("logs");
+    std::ofstream("logs/realtime.json") << report.dump(2) << std::endl;
+
+    auto line = [&](const char* name, const rt::Histogram& h) {
+        std::cout << "[realtime] " << name << " p50=" << us(h.percentile(0.50)) << "us"
+                  << " p99=" << us(h.percentile(0.99)) << "us"
+                  << " p99.9=" << us(h.percentile(0.999)) << "us"
+                  << " max=" << us(h.max()) << "us\n";
+    };
+    line("compute", compute_h);
+    line("tick   ", tick_h);
+    line("jitter ", jitter_h);
+    std::cout << "[realtime] deadline_misses=" << misses << "/" << ticks
+              << " skipped_releases=" << skipped << " plant_timeouts=" << plant_timeouts
+              << " avg_return=" << (episodes ? ret_sum / episodes : 0.0)
+              << " (report: logs/realtime.json)\n";
+
+    bool over = misses > max_misses;
+    if (budget_us > 0.0 && us(compute_h.percentile(0.99)) > budget_us) {
+        std::cerr << "[realtime] compute p99 exceeds budget " << budget_us << "us\n";
+        over = true;
+    }
+    if (misses > max_misses)
+        std::cerr << "[realtime] deadline misses exceed realtime_max_misses=" << max_misses << "\n";
+    return over ? 2 : 0;
+}
+
+// ------------ 主机自动调参：子进程跑 bench 试验，坐标轮换搜索 ------------
+// 运行 argv，stdout/stderr 重定向到 log_path，返回退出码（异常退出返回 -1）
+static int spawn_and_wait(const std::vector<std::string>& args, const std::string& log_path) {
+    std::vector<char*> argv;
+    for (const auto& a : args) argv.push_back(const_cast<char*>(a.c_str()));
+    argv.push_back(nullptr);
+
+    posix_spawn_file_actions_t fa;
+    posix_spawn_file_actions_init(&fa);
+    posix_spawn_file_actions_addopen(&fa, STDOUT_FILENO, log_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    posix_spawn_file_actions_adddup2(&fa, STDOUT_FILENO, STDERR_FILENO);
+    pid_t pid = 0;
+    const int rc = ::posix_spawn(&pid, argv[0], &fa, nullptr, argv.data(), environ);
+    posix_spawn_file_actions_destroy(&fa);
+    if (rc != 0) {
+        std::cerr << "[autotune] spawn failed: " << std::strerror(rc) << "\n";
+        return -1;
+    }
+    int status = 0;
+    while (::waitpid(pid, &status, 0) < 0 && errno == EINTR) {}
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+int autotune_loop(const YAML::Node& y) {
+    using json = nlohmann::json;
+    auto ints = [&](const char* key, std::vector<int> def) {
+        if (!y[key]) return def;
+        return y[key].IsSequence() ? y[key].as<std::vector<int>>() : std::vector<int>{y[key].as<int>()};
+    };
+    // 搜索空间（顺序即坐标轮换顺序）；intra_op_threads 的 0 表示 libtorch 默认
+    const std::vector<std::pair<std::string, std::vector<int>>> space = {
+        {"intra_op_threads", ints("autotune_intra_op_threads", {1, 2, 4, 0})},
+        {"inter_op_threads", ints("autotune_inter_op_threads", {1, 2})},
+        {"pin",              ints("autotune_pin", {0, 1})},
+        {"batch_size",       ints("autotune_batch_size", {128, 256, 512})},
+        {"hidden",           ints("autotune_hidden", {256})},
+        {"updates_per_step", ints("autotune_updates_per_step", {1, 2})},
+    };
+    const int trial_steps  = y["autotune_trial_steps"]  ? y["autotune_trial_steps"].as<int>()  : 1500;
+    const int warmup_steps = y["autotune_warmup_steps"] ? y["autotune_warmup_steps"].as<int>() : 500;
+    const int repeats      = y["autotune_repeats"]      ? y["autotune_repeats"].as<int>()      : 1;
+    const std::string objective = y["autotune_objective"] ? y["autotune_objective"].as<std::string>() : "samples_per_sec";
+    const std::string out_path  = y["autotune_out"]       ? y["autotune_out"].as<std::string>()       : "config.tuned.yaml";
+    if (objective != "env_steps_per_sec" && objective != "updates_per_sec" && objective != "samples_per_sec") {
+        std::cerr << "[autotune] autotune_objective must be env_steps_per_sec|updates_per_sec|samples_per_sec\n";
+        return 1;
+    }
+
+    std::error_code ec;
+    const std::string exe = fs::read_symlink("/proc/self/exe", ec).string();
+    if (ec) { std::cerr << "[autotune] cannot resolve /proc/self/exe\n"; return 1; }
+    const fs::path work = "logs/autotune";
+    fs::create_directories(work);
+
+    // 当前进程允许使用的 CPU，pin=1 时按顺序取前 n 个
+    std::vector<int> allowed;
+    cpu_set_t cur;
+    if (::sched_getaffinity(0, sizeof(cur), &cur) == 0)
+        for (int c=0; c<CPU_SETSIZE; ++c) if (CPU_ISSET(c, &cur)) allowed.push_back(c);
+    if (allowed.empty()) allowed.push_back(0);
+
+    // 起点：base config 中的取值，缺省时取候选的第一个
+    std::map<std::string, int> best;
+    for (const auto& [key, cand] : space) {
+        if (key == "pin") best[key] = (y["cpu_affinity"] && y["cpu_affinity"].size() > 0) ? 1 : cand.front();
+        else best[key] = y[key] ? y[key].as<int>() : cand.front();
+    }
+
+    auto knob_tag = [](const std::map<std::string, int>& knobs) {
+        std::string tag;
+        for (const auto& [k, v] : knobs) tag += k + "=" + std::to_string(v) + " ";
+        return tag;
+    };
+    std::map<std::string, json> cache;   // 同一组取值只跑一次
+    json trials = json::array();
+    auto run_trial = [&](const std::map<std::string, int>& knobs) -> json {
+        const std::string tag = knob_tag(knobs);
+        if (cache.count(tag)) return cache[tag];
+
+        YAML::Node cfg = YAML::Clone(y);
+        for (const auto& [k, v] : knobs) if (k != "pin") cfg[k] = v;
+        const int threads = knobs.at("intra_op_threads") > 0 ? knobs.at("intra_op_threads") : (int)allowed.size();
+        std::vector<int> cpus;
+        if (knobs.at("pin"))
+            for (int i=0; i<std::min<int>(threads, (int)allowed.size()); ++i) cpus.push_back(allowed[i]);
+        cfg["cpu_affinity"] = cpus;
+        cfg["bench_steps"] = trial_steps;
+        cfg["bench_warmup_steps"] = warmup_steps;
+        cfg["bench_eval_episodes"] = 1;
+
+        const int id = (int)trials.size();
+        const std::string cfg_file = (work / ("trial_" + std::to_string(id) + ".yaml")).string();
+        const std::string out_file = (work / ("trial_" + std::to_string(id) + ".json")).string();
+        { YAML::Emitter em; em << cfg; std::ofstream(cfg_file) << em.c_str() << "\n"; }
+
+        std::vector<double> scores;
+        json last;
+        for (int r=0; r<repeats; ++r) {
+            const int rc = spawn_and_wait({exe, "--mode", "bench", "--config", cfg_file,
+                                           "--baseline", (work / "none.json").string(), "--bench-out", out_file},
+                                          (work / ("trial_" + std::to_string(id) + ".log")).string());
+            std::ifstream in(out_file);
+            if (rc != 0 || !in.is_open()) break;
+            try { in >> last; } catch (...) { break; }
+            const double ups = last.value("updates_per_sec", 0.0);
+            scores.push_back(objective == "env_steps_per_sec" ? last.value("env_steps_per_sec", 0.0)
+                           : objective == "updates_per_sec"   ? ups
+                           : ups * knobs.at("batch_size"));
+        }
+        json t = {{"id", id}, {"knobs", knobs}, {"ok", (int)scores.size() == repeats}};
+        if (!scores.empty()) {
+            std::sort(scores.begin(), scores.end());
+            t["score"] = scores[scores.size() / 2];   // 多次重复取中位数
+            t["env_steps_per_sec"] = last.value("env_steps_per_sec", 0.0);
+            t["updates_per_sec"] = last.value("updates_per_sec", 0.0);
+        } else {
+            t["score"] = 0.0;
+        }
+        std::cout << "[autotune] trial " << id << ": " << tag << "-> " << objective << "="
+                  << t["score"].get<double>() << (t["ok"].get<bool>() ? "" : "  (failed)") << "\n";
+        trials.push_back(t);
+        cache[tag] = t;
+        return t;
+    };
+
+    double best_score = run_trial(best)["score"].get<double>();
+    for (const auto& [key, cand] : space) {
+        for (int v : cand) {
+            if (v == best[key]) continue;
+            auto knobs = best;
+            knobs[key] = v;
+            const double sc = run_trial(knobs)["score"].get<double>();
+            if (sc > best_score) { best_score = sc; best = knobs; }
+        }
+    }
+    if (best_score <= 0.0) {
+        std::cerr << "[autotune] no successful trial, see " << work.string() << "/*.log\n";
+        return 1;
+    }
+    const json& winner = cache[knob_tag(best)];
+
+    // 写出 overlay：只含调过的键，配合 --overlay 覆盖 base config
+    std::ofstream out(out_path);
+    if (!out.is_open()) { std::cerr << "[autotune] cannot write " << out_path << "\n"; return 1; }
+    const int threads = best["intra_op_threads"] > 0 ? best["intra_op_threads"] : (int)allowed.size();
+    out << "# autotune: " << trials.size() << " trials, objective " << objective << "=" << best_score
+        << " (env_steps_per_sec=" << winner.value("env_steps_per_sec", 0.0)
+        << ", updates_per_sec=" << winner.value("updates_per_sec", 0.0) << ")\n"
+        << "# 用法：./sac_pendulum --mode train --overlay " << out_path << "\n"
+        << "intra_op_threads: " << best["intra_op_threads"] << "\n"
+        << "inter_op_threads: " << best["inter_op_threads"] << "\n"
+        << "cpu_affinity: [";
+    if (best["pin"])
+        for (int i=0; i<std::min<int>(threads, (int)allowed.size()); ++i) out << (i ? ", " : "") << allowed[i];
+    out << "]\n"
+        << "batch_size: " << best["batch_size"] << "\n"
+        << "hidden: " << best["hidden"] << "\n"
+        << "updates_per_step: " << best["updates_per_step"] << "\n";
+
+    std::ofstream(work / "autotune.json") << json{{"objective", objective}, {"best", best},
+                                                 {"best_score", best_score}, {"trials", trials}}.dump(2) << std::endl;
+    std::cout << "[autotune] best " << objective << "=" << best_score << ", overlay written to " << out_path
+              << " (all trials: " << (work / "autotune.json").string() << ")\n";
+    return 0;
+}
+
 // ------------ main ------------
 int main(int argc, char** argv) {
     std::string mode = get_arg(argc, argv, "--mode", "");
-    if (mode != "train" && mode != "eval") {
-        std::cerr << "Usage: ./sac_pendulum --mode train|eval [--resume] [--config path]\n";
+    if (mode != "train" && mode != "eval" && mode != "export" && mode != "offline" && mode != "bench"
+        && mode != "distill" && mode != "realtime" && mode != "autotune") {
+        std::cerr << "Usage: ./sac_pendulum --mode train|eval|export|offline|bench|distill|realtime|autotune [--resume]"
+                     " [--config path] [--overlay tuned.yaml]"
+                     " [--out policy.bin] [--dataset data.bin] [--student dir] [--policy policy.bin]"
+                     " [--baseline bench/baseline.json] [--write-baseline] [--bench-out result.json] [--critic-split 0|1]\n";
         return 1;
     }
     bool resume = has_flag(argc, argv, "--resume");
@@ -238,6 +1259,18 @@ int main(int argc, char** argv) {
         std::cerr << "[config] cannot load " << cfg_path << "\n";
         return 1;
     }
+    // 可选：叠加 autotune 生成的 overlay（同名键覆盖 base）
+    if (std::string ov = get_arg(argc, argv, "--overlay", ""); !ov.empty()) {
+        try {
+            merge_overlay(y, YAML::LoadFile(ov));
+            std::cout << "[config] overlay: " << ov << "\n";
+        } catch (...) {
+            std::cerr << "[config] cannot load overlay " << ov << "\n";
+            return 1;
+        }
+    }
+    if (mode == "autotune") return autotune_loop(y);
+    apply_thread_config(y);
 
     SACConfig sac;
     sac.obs_dim         = y["obs_dim"]        ? y["obs_dim"].as<int>()        : 3;
@@ -251,9 +1284,43 @@ int main(int argc, char** argv) {
     sac.autotune_alpha  = y["autotune_alpha"] ? y["autotune_alpha"].as<bool>(): true;
     sac.target_entropy  = y["target_entropy"] ? y["target_entropy"].as<double>(): -1.0;
     sac.updates_per_step= y["updates_per_step"] ? y["updates_per_step"].as<int>() : 1;
+    sac.autocast_bf16   = y["autocast_bf16"]  ? y["autocast_bf16"].as<bool>() : false;
+    sac.critic_split    = y["critic_split"]   ? y["critic_split"].as<bool>()  : false;
+    // 命令行覆盖，便于 bench 直接对比两条路径
+    if (std::string cs = get_arg(argc, argv, "--critic-split", ""); !cs.empty()) {
+        if (cs != "0" && cs != "1") {
+            std::cerr << "--critic-split expects 0 or 1\n";
+            return 1;
+        }
+        sac.critic_split = cs == "1";
+    }
+
+    if (mode == "export")
+        return export_loop(sac, get_arg(argc, argv, "--out", "checkpoints/policy.bin"));
+
+    if (mode == "bench") {
+        std::string baseline = get_arg(argc, argv, "--baseline",
+                                       y["bench_baseline"] ? y["bench_baseline"].as<std::string>() : "bench/baseline.json");
+        return bench_loop(sac, y, baseline, has_flag(argc, argv, "--write-baseline"),
+                          get_arg(argc, argv, "--bench-out", ""));
+    }
+
+    if (mode == "offline") {
+        std::string ds = get_arg(argc, argv, "--dataset",
+                                 y["offline_dataset"] ? y["offline_dataset"].as<std::string>() : "data/offline.bin");
+        return offline_loop(sac, y, ds);
+    }
+
+    if (mode == "distill") return distill_loop(sac, y);
+
+    if (mode == "realtime") {
+        std::string policy = get_arg(argc, argv, "--policy",
+                                     y["realtime_policy"] ? y["realtime_policy"].as<std::string>() : "checkpoints/policy.bin");
+        return realtime_loop(sac, y, policy);
+    }
 
-    if (mode == "train") train_loop(sac, y, resume);
-    else                 eval_loop(sac, y);
+    if (mode == "train") return train_loop(sac, y, resume);
+    eval_loop(sac, y, get_arg(argc, argv, "--student", ""));
 
     return 0;
 }
@@ -0,0 +1,21 @@
+#pragma once
+// libtorch 侧的扁平权重导出辅助：Linear -> flat_policy::LayerWeights。
+// 单独成头文件，policy_runtime.h 保持不依赖 libtorch。
+#include <torch/torch.h>
+#include "runtime/policy_runtime.h"
+
+namespace flat_policy {
+
+inline LayerWeights from_linear(const torch::nn::Linear& lin) {
+    torch::NoGradGuard ng;
+    auto W = lin->weight.detach().to(torch::kCPU, torch::kFloat32).contiguous();
+    auto b = lin->bias.detach().to(torch::kCPU, torch::kFloat32).contiguous();
+    LayerWeights L;
+    L.out = (uint32_t)W.size(0);
+    L.in  = (uint32_t)W.size(1);
+    L.W.assign(W.data_ptr<float>(), W.data_ptr<float>() + W.numel());
+    L.b.assign(b.data_ptr<float>(), b.data_ptr<float>() + b.numel());
+    return L;
+}
+
+} // namespace flat_policy
@@ -0,0 +1,52 @@
+// plant_server：外部被控对象的本地替身。监听 127.0.0.1:<port> 的 UDP，
+// 按 rt::PlantRequest 推进 PendulumEnv 并回 rt::PlantReply，供 --mode realtime 的 udp 模式使用。
+// 用法：./plant_server [--port 47001] [--delay_us 0]
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "env/pendulum.h"
+#include "runtime/realtime.h"
+
+int main(int argc, char** argv) {
+    int port = 47001, delay_us = 0;
+    for (int i = 1; i + 1 < argc; ++i) {
+        std::string k = argv[i];
+        if (k == "--port")          port     = std::stoi(argv[++i]);
+        else if (k == "--delay_us") delay_us = std::stoi(argv[++i]);   // 模拟对象响应时间
+    }
+
+    int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd < 0 || ::bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        std::cerr << "[plant] cannot bind 127.0.0.1:" << port << ": " << std::strerror(errno) << "\n";
+        return 1;
+    }
+    std::cout << "[plant] listening on udp://127.0.0.1:" << port << "\n";
+
+    PendulumEnv env;
+    std::array<double,3> s = env.reset(0);
+    for (;;) {
+        rt::PlantRequest q;
+        sockaddr_in peer{};
+        socklen_t plen = sizeof(peer);
+        if (::recvfrom(fd, &q, sizeof(q), 0, (sockaddr*)&peer, &plen) != (ssize_t)sizeof(q)) continue;
+
+        rt::PlantReply r{q.seq, {0.f, 0.f, 0.f}, 0.f};
+        if (q.cmd == rt::kPlantReset) {
+            s = env.reset(q.seed);
+        } else {
+            auto out = env.step(q.action);
+            s = out.state;
+            r.reward = (float)out.reward;
+        }
+        for (int i = 0; i < 3; ++i) r.obs[i] = (float)s[i];
+        if (delay_us > 0) std::this_thread::sleep_for(std::chrono::microseconds(delay_us));
+        ::sendto(fd, &r, sizeof(r), 0, (sockaddr*)&peer, plen);
+    }
+}
@@ -0,0 +1,179 @@
+#pragma once
+// 无 libtorch 依赖的策略推理运行时（header-only）。
+//
+// 扁平权重文件格式（小端，全部 4 字节对齐），version 1：
+//   [0]  char     magic[4] = "SACP"
+//   [4]  uint32   version
+//   [8]  uint32   n_layers          线性层数（>=1）
+//   [12] uint32   flags             保留，写 0
+//   [16] float32  act_limit         输出 = tanh(最后一层) * act_limit
+//   [20] uint32   reserved
+//   [24] uint32   dims[n_layers+1]  dims[0]=obs_dim, dims[n_layers]=act_dim
+//   然后逐层：W[out][in]（行主序 float32），b[out]
+// 隐藏层激活为 ReLU，最后一层接 tanh，与 Actor::act_deterministic 一致。
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace flat_policy {
+
+constexpr char     kMagic[4] = {'S', 'A', 'C', 'P'};
+constexpr uint32_t kVersion  = 1;
+constexpr size_t   kHeaderBytes = 24;
+constexpr uint32_t kMaxWidth = 1u << 16;   // 单层宽度上限，load 据此保证字节数计算不溢出
+
+// 一层线性层的权重（写文件用）
+struct LayerWeights {
+    uint32_t in = 0, out = 0;
+    std::vector<float> W;  // [out*in]
+    std::vector<float> b;  // [out]
+};
+
+// 写出扁平权重文件；成功返回 true
+inline bool write_file(const std::string& path, float act_limit,
+                       const std::vector<LayerWeights>& layers,
+                       std::string* err = nullptr) {
+    auto fail = [&](const std::string& m) { if (err) *err = m; return false; };
+    if (layers.empty()) return fail("no layers");
+    for (size_t i = 0; i < layers.size(); ++i) {
+        const auto& L = layers[i];
+        if (L.W.size() != (size_t)L.in * L.out || L.b.size() != L.out)
+            return fail("layer " + std::to_string(i) + " has inconsistent shape");
+        if (i > 0 && layers[i-1].out != L.in)
+            return fail("layer " + std::to_string(i) + " input dim mismatch");
+    }
+
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return fail("cannot open " + path);
+
+    uint32_t hdr_u32[6] = {0, kVersion, (uint32_t)layers.size(), 0, 0, 0};
+    std::memcpy(&hdr_u32[0], kMagic, 4);
+    std::memcpy(&hdr_u32[4], &act_limit, 4);
+    std::vector<uint32_t> dims;
+    dims.push_back(layers.front().in);
+    for (const auto& L : layers) dims.push_back(L.out);
+
+    bool ok = std::fwrite(hdr_u32, 4, 6, f) == 6 &&
+              std::fwrite(dims.data(), 4, dims.size(), f) == dims.size();
+    for (const auto& L : layers) {
+        if (!ok) break;
+        ok = std::fwrite(L.W.data(), 4, L.W.size(), f) == L.W.size() &&
+             std::fwrite(L.b.data(), 4, L.b.size(), f) == L.b.size();
+    }
+    ok = (std::fclose(f) == 0) && ok;
+    return ok ? true : fail("write failed: " + path);
+}
+
+// mmap 加载并执行确定性策略。加载后推理路径不做任何堆分配。
+class Policy {
+public:
+    Policy() = default;
+    Policy(const Policy&) = delete;
+    Policy& operator=(const Policy&) = delete;
+    ~Policy() { unmap_(); }
+
+    bool load(const std::string& path, std::string* err = nullptr) {
+        auto fail = [&](const std::string& m) { unmap_(); if (err) *err = m; return false; };
+        unmap_();
+
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return fail("cannot open " + path);
+        struct stat st{};
+        if (::fstat(fd, &st) != 0 || st.st_size < (off_t)kHeaderBytes) { ::close(fd); return fail("file too small: " + path); }
+        void* p = ::mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) return fail("mmap failed: " + path);
+        base_ = p; size_ = (size_t)st.st_size;
+
+        const auto* u = static_cast<const uint32_t*>(base_);
+        if (std::memcmp(base_, kMagic, 4) != 0) return fail("bad magic");
+        if (u[1] != kVersion) return fail("unsupported version " + std::to_string(u[1]));
+        const uint32_t n_layers = u[2];
+        if (n_layers == 0 || n_layers > 64) return fail("bad layer count");
+        std::memcpy(&act_limit_, &u[4], 4);
+
+        size_t off = kHeaderBytes + 4ull * (n_layers + 1);
+        if (off > size_) return fail("truncated header");
+        const uint32_t* dims = u + kHeaderBytes / 4;
+        dims_.assign(dims, dims + n_layers + 1);
+
+        layers_.clear();
+        size_t max_width = 0;
+        for (uint32_t i = 0; i < n_layers; ++i) {
+            const size_t in = dims_[i], out = dims_[i+1];
+            if (in == 0 || out == 0) return fail("zero-width layer");
+            if (in > kMaxWidth || out > kMaxWidth) return fail("layer too wide");
+            const size_t bytes = 4 * (in * out + out);
+            if (bytes > size_ - off) return fail("truncated weights");
+            const float* W = reinterpret_cast<const float*>(static_cast<const char*>(base_) + off);
+            layers_.push_back({W, W + in * out, (uint32_t)in, (uint32_t)out});
+            off += bytes;
+            max_width = std::max(max_width, out);
+        }
+        if (off != size_) return fail("trailing bytes in file");
+
+        buf_a_.assign(max_width, 0.0f);
+        buf_b_.assign(max_width, 0.0f);
+        return true;
+    }
+
+    bool loaded() const { return base_ != nullptr; }
+    int obs_dim() const { return dims_.empty() ? 0 : (int)dims_.front(); }
+    int act_dim() const { return dims_.empty() ? 0 : (int)dims_.back(); }
+    float act_limit() const { return act_limit_; }
+    const std::vector<uint32_t>& dims() const { return dims_; }
+    size_t file_bytes() const { return size_; }
+
+    // obs: [obs_dim]  ->  act: [act_dim]（真实尺度，已乘 act_limit）
+    void act(const float* obs, float* act) {
+        const float* x = obs;
+        float* y = buf_a_.data();
+        for (size_t l = 0; l < layers_.size(); ++l) {
+            const auto& L = layers_[l];
+            const bool last = (l + 1 == layers_.size());
+            float* dst = last ? act : y;
+            for (uint32_t o = 0; o < L.out; ++o) {
+                const float* w = L.W + (size_t)o * L.in;
+                float acc = L.b[o];
+                for (uint32_t i = 0; i < L.in; ++i) acc += w[i] * x[i];
+                dst[o] = last ? std::tanh(acc) * act_limit_ : (acc > 0.0f ? acc : 0.0f);
+            }
+            x = dst;
+            y = (y == buf_a_.data()) ? buf_b_.data() : buf_a_.data();
+        }
+    }
+
+    // 便捷接口：单维动作
+    double act1(const float* obs) {
+        float a = 0.0f;
+        act(obs, &a);
+        return a;
+    }
+
+private:
+    struct Layer { const float* W; const float* b; uint32_t in, out; };
+
+    void* base_ = nullptr;
+    size_t size_ = 0;
+    float act_limit_ = 1.0f;
+    std::vector<uint32_t> dims_;
+    std::vector<Layer> layers_;
+    std::vector<float> buf_a_, buf_b_;  // 隐藏层 ping-pong 缓冲
+
+    void unmap_() {
+        if (base_) ::munmap(base_, size_);
+        base_ = nullptr; size_ = 0;
+        layers_.clear(); dims_.clear();
+    }
+};
+
+} // namespace flat_policy
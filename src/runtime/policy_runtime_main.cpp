@@ -0,0 +1,77 @@
+// policy_runtime：不链接 libtorch，直接加载扁平权重文件跑确定性策略。
+// 用法：./policy_runtime <policy.bin> [--episodes N] [--max_ep_len T]
+#include <chrono>
+#include <iostream>
+#include <string>
+
+#include "runtime/policy_runtime.h"
+#include "env/pendulum.h"
+#include "utils/proc_info.h"
+
+int main(int argc, char** argv) {
+    using clock = std::chrono::steady_clock;
+    const auto t_start = clock::now();
+
+    if (argc < 2) {
+        std::cerr << "Usage: ./policy_runtime <policy.bin> [--episodes N] [--max_ep_len T]\n";
+        return 1;
+    }
+    std::string path = argv[1];
+    int episodes = 5, max_ep_len = 200;
+    for (int i = 2; i + 1 < argc; ++i) {
+        std::string k = argv[i];
+        if (k == "--episodes")   episodes   = std::stoi(argv[++i]);
+        else if (k == "--max_ep_len") max_ep_len = std::stoi(argv[++i]);
+    }
+
+    flat_policy::Policy policy;
+    std::string err;
+    if (!policy.load(path, &err)) {
+        std::cerr << "[runtime] load failed: " << err << "\n";
+        return 1;
+    }
+    if (policy.obs_dim() != 3 || policy.act_dim() != 1) {
+        std::cerr << "[runtime] expect obs_dim=3 act_dim=1, got "
+                  << policy.obs_dim() << "/" << policy.act_dim() << "\n";
+        return 1;
+    }
+    const auto t_loaded = clock::now();
+
+    PendulumEnv env;
+    // 冷启动：第一个动作输出时刻，分别从进程创建（含 exec/动态链接）和进入 main 算起
+    auto s = env.reset(2000);
+    float obs[3] = {(float)s[0], (float)s[1], (float)s[2]};
+    (void)policy.act1(obs);
+    const auto t_first = clock::now();
+    const double first_since_start_us = process_age_us();
+
+    auto us = [](clock::duration d) {
+        return std::chrono::duration<double, std::micro>(d).count();
+    };
+    std::cout << "[runtime] load=" << us(t_loaded - t_start) << "us"
+              << " first_action=" << first_since_start_us << "us since process start"
+              << " (" << us(t_first - t_start) << "us since main)"
+              << " weights=" << policy.file_bytes() << "B"
+              << " exe=" << self_exe_bytes() << "B"
+              << " shared_libs=" << mapped_library_bytes() << "B\n";
+
+    double infer_us = 0.0;
+    long infer_n = 0;
+    for (int e = 0; e < episodes; ++e) {
+        s = env.reset(2000 + e);
+        double ep_ret = 0.0;
+        for (int t = 0; t < max_ep_len; ++t) {
+            obs[0] = (float)s[0]; obs[1] = (float)s[1]; obs[2] = (float)s[2];
+            auto t0 = clock::now();
+            double a = policy.act1(obs);
+            infer_us += us(clock::now() - t0); infer_n++;
+            auto out = env.step(a);
+            ep_ret += out.reward;
+            s = out.state;
+        }
+        std::cout << "[runtime] episode=" << e << " return=" << ep_ret << "\n";
+    }
+    if (infer_n > 0)
+        std::cout << "[runtime] mean inference=" << infer_us / infer_n << "us\n";
+    return 0;
+}
@@ -0,0 +1,163 @@
+#pragma once
+// 固定周期控制回路用的工具（header-only，无 libtorch 依赖）：
+// 绝对时刻睡眠、线程绑核/实时优先级、定长直方图、本地 UDP 被控对象协议。
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace rt {
+
+inline int64_t now_ns() {
+    timespec ts;
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// 睡到绝对时刻 t_ns（CLOCK_MONOTONIC），不随每次计算耗时累积漂移
+inline void sleep_until_ns(int64_t t_ns) {
+    timespec ts{(time_t)(t_ns / 1000000000LL), (long)(t_ns % 1000000000LL)};
+    while (::clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+}
+
+// 当前线程绑定到单个 CPU
+inline bool pin_current_thread(int cpu, std::string* err = nullptr) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    const int rc = ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set);
+    if (rc != 0 && err) *err = std::strerror(rc);
+    return rc == 0;
+}
+
+// SCHED_FIFO 优先级（一般需要 CAP_SYS_NICE 或 rtprio 限额）
+inline bool set_fifo_priority(int prio, std::string* err = nullptr) {
+    sched_param sp{};
+    sp.sched_priority = prio;
+    const int rc = ::pthread_setschedparam(::pthread_self(), SCHED_FIFO, &sp);
+    if (rc != 0 && err) *err = std::strerror(rc);
+    return rc == 0;
+}
+
+// 定宽直方图（纳秒），构造时一次性分配，record() 不分配内存。
+// 超出范围的样本落在最后一个桶，max 仍精确记录。
+class Histogram {
+public:
+    Histogram(int64_t bin_ns, size_t bins) : bin_ns_(std::max<int64_t>(1, bin_ns)), counts_(bins + 1, 0) {}
+
+    void record(int64_t v) {
+        if (v < 0) v = 0;
+        const size_t i = std::min((size_t)(v / bin_ns_), counts_.size() - 1);
+        ++counts_[i];
+        ++n_;
+        sum_ += v;
+        max_ = std::max(max_, v);
+        min_ = n_ == 1 ? v : std::min(min_, v);
+    }
+
+    uint64_t count() const { return n_; }
+    int64_t  max()   const { return max_; }
+    int64_t  min()   const { return min_; }
+    double   mean()  const { return n_ ? (double)sum_ / (double)n_ : 0.0; }
+    int64_t  bin_ns() const { return bin_ns_; }
+    const std::vector<uint64_t>& counts() const { return counts_; }
+
+    // 分位数（取桶上沿；落在溢出桶时返回 max）
+    int64_t percentile(double q) const {
+        if (n_ == 0) return 0;
+        const uint64_t target = (uint64_t)std::max(1.0, q * (double)n_ + 0.5);
+        uint64_t acc = 0;
+        for (size_t i = 0; i < counts_.size(); ++i) {
+            acc += counts_[i];
+            if (acc >= target) return i + 1 == counts_.size() ? max_ : std::min(max_, (int64_t)(i + 1) * bin_ns_);
+        }
+        return max_;
+    }
+
+private:
+    int64_t bin_ns_;
+    std::vector<uint64_t> counts_;   // 最后一个为溢出桶
+    uint64_t n_ = 0;
+    int64_t sum_ = 0, max_ = 0, min_ = 0;
+};
+
+// ---------------- 本地 UDP 被控对象协议 ----------------
+// 控制器 -> 对象：PlantRequest；对象 -> 控制器：PlantReply（seq 原样带回，用于丢弃过期回包）
+enum : uint32_t { kPlantReset = 0, kPlantStep = 1 };
+
+struct PlantRequest {
+    uint32_t cmd;
+    uint32_t seq;
+    uint32_t seed;     // 仅 reset 使用
+    float    action;   // 仅 step 使用
+};
+
+struct PlantReply {
+    uint32_t seq;
+    float    obs[3];
+    float    reward;
+};
+
+// 控制器侧：向 127.0.0.1:port 发请求并等待对应 seq 的回包
+class UdpPlantClient {
+public:
+    ~UdpPlantClient() { if (fd_ >= 0) ::close(fd_); }
+
+    bool open(int port, std::string* err = nullptr) {
+        fd_ = ::socket(AF_INET, SOCK_DGRAM, 0);
+        if (fd_ < 0) { if (err) *err = std::strerror(errno); return false; }
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons((uint16_t)port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (::connect(fd_, (sockaddr*)&addr, sizeof(addr)) != 0) {
+            if (err) *err = std::strerror(errno);
+            return false;
+        }
+        return true;
+    }
+
+    // 超过 deadline_ns（CLOCK_MONOTONIC）仍未收到回包则返回 false
+    bool reset(uint32_t seed, float* obs, int64_t deadline_ns) {
+        PlantRequest q{kPlantReset, ++seq_, seed, 0.0f};
+        return roundtrip_(q, obs, nullptr, deadline_ns);
+    }
+    bool step(float action, float* obs, float* reward, int64_t deadline_ns) {
+        PlantRequest q{kPlantStep, ++seq_, 0, action};
+        return roundtrip_(q, obs, reward, deadline_ns);
+    }
+
+private:
+    int fd_ = -1;
+    uint32_t seq_ = 0;
+
+    bool roundtrip_(const PlantRequest& q, float* obs, float* reward, int64_t deadline_ns) {
+        if (::send(fd_, &q, sizeof(q), 0) != (ssize_t)sizeof(q)) return false;
+        PlantReply r;
+        for (;;) {
+            const int64_t left = deadline_ns - now_ns();
+            if (left <= 0) return false;
+            timespec to{(time_t)(left / 1000000000LL), (long)(left % 1000000000LL)};
+            pollfd p{fd_, POLLIN, 0};
+            if (::ppoll(&p, 1, &to, nullptr) <= 0) return false;
+            if (::recv(fd_, &r, sizeof(r), 0) != (ssize_t)sizeof(r)) continue;
+            if (r.seq != q.seq) continue;   // 上一拍超时后迟到的回包
+            std::memcpy(obs, r.obs, sizeof(r.obs));
+            if (reward) *reward = r.reward;
+            return true;
+        }
+    }
+};
+
+} // namespace rt
@@ -10,14 +10,19 @@ inline torch::Tensor normal_log_prob(const torch::Tensor& x, const torch::Tensor
     return log_prob; // same shape as x
 }
 
-struct ActorImpl : torch::nn::Module {
+// Cloneable：snapshot() 用 clone() 深拷贝权重
+struct ActorImpl : torch::nn::Cloneable<ActorImpl> {
     torch::nn::Linear fc1{nullptr}, fc2{nullptr}, mean{nullptr}, log_std{nullptr};
 
-    int obs_dim, act_dim;
+    int obs_dim, act_dim, hidden;
     double log_std_min = -20.0, log_std_max = 2.0;
 
-    ActorImpl(int obs_dim_=3, int hidden=256, int act_dim_=1)
-    : obs_dim(obs_dim_), act_dim(act_dim_) {
+    ActorImpl(int obs_dim_=3, int hidden_=256, int act_dim_=1)
+    : obs_dim(obs_dim_), act_dim(act_dim_), hidden(hidden_) {
+        reset();
+    }
+
+    void reset() override {
         fc1 = register_module("fc1", torch::nn::Linear(obs_dim, hidden));
         fc2 = register_module("fc2", torch::nn::Linear(hidden, hidden));
         mean = register_module("mean", torch::nn::Linear(hidden, act_dim));
@@ -27,8 +32,9 @@ struct ActorImpl : torch::nn::Module {
     std::pair<torch::Tensor, torch::Tensor> forward_impl(const torch::Tensor& x) {
         auto h = torch::relu(fc1->forward(x));
         h = torch::relu(fc2->forward(h));
-        auto mu = mean->forward(h);
-        auto ls = torch::clamp(log_std->forward(h), log_std_min, log_std_max);
+        // autocast 下线性层输出为 bf16，分布相关计算统一回到 fp32
+        auto mu = mean->forward(h).to(torch::kFloat32);
+        auto ls = torch::clamp(log_std->forward(h).to(torch::kFloat32), log_std_min, log_std_max);
         return {mu, ls};
     }
 
@@ -0,0 +1,88 @@
+#pragma once
+#include <torch/torch.h>
+#include <c10/core/Allocator.h>
+#include <c10/util/ThreadLocalDebugInfo.h>
+#include <memory>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "sac/sac_agent.h"
+
+struct EvalJob {
+    long step = 0;          // 快照对应的训练步
+    AgentSnapshot snap;
+    double snapshot_us = 0; // 拷贝快照耗时
+};
+
+// 后台评估线程：训练循环提交权重快照后立即返回，评估在独立线程上进行，
+// 评估本身由调用方给出的 eval_fn(snapshot) -> avg_return 完成，
+// 完成后在该线程上调用 on_done(job, avg_return)。任务按提交顺序执行。
+// alloc_tracker 非空时装到工作线程上（PROFILER_STATE），否则快照在训练线程分配、
+// 在工作线程释放，c10 只会记到分配。
+class AsyncEvaluator {
+public:
+    using EvalFn   = std::function<double(const AgentSnapshot&)>;
+    using Callback = std::function<void(const EvalJob&, double)>;
+
+    AsyncEvaluator(EvalFn eval_fn, Callback on_done,
+                   std::shared_ptr<c10::MemoryReportingInfoBase> alloc_tracker = nullptr)
+    : eval_fn_(std::move(eval_fn)), on_done_(std::move(on_done)), alloc_tracker_(std::move(alloc_tracker)),
+      worker_([this] { run_(); }) {}
+
+    ~AsyncEvaluator() { finish(); }
+
+    void submit(EvalJob job) {
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            jobs_.push_back(std::move(job));
+        }
+        cv_.notify_one();
+    }
+
+    size_t pending() {
+        std::lock_guard<std::mutex> lk(mu_);
+        return jobs_.size();
+    }
+
+    // 等待已提交的评估全部完成并结束线程
+    void finish() {
+        {
+            std::lock_guard<std::mutex> lk(mu_);
+            stop_ = true;
+        }
+        cv_.notify_one();
+        if (worker_.joinable()) worker_.join();
+    }
+
+private:
+    EvalFn eval_fn_;
+    Callback on_done_;
+
+    std::mutex mu_;
+    std::condition_variable cv_;
+    std::deque<EvalJob> jobs_;
+    bool stop_ = false;
+    std::shared_ptr<c10::MemoryReportingInfoBase> alloc_tracker_;
+    std::thread worker_;   // 最后初始化：其余成员就绪后才启动线程
+
+    void run_() {
+        std::unique_ptr<c10::DebugInfoGuard> dg;
+        if (alloc_tracker_)
+            dg = std::make_unique<c10::DebugInfoGuard>(c10::DebugInfoKind::PROFILER_STATE, alloc_tracker_);
+        torch::NoGradGuard ng;   // 梯度模式是线程局部的
+        for (;;) {
+            EvalJob job;
+            {
+                std::unique_lock<std::mutex> lk(mu_);
+                cv_.wait(lk, [this] { return stop_ || !jobs_.empty(); });
+                if (jobs_.empty()) return;   // stop_ 且已清空
+                job = std::move(jobs_.front());
+                jobs_.pop_front();
+            }
+            on_done_(job, eval_fn_(job.snap));
+        }
+    }
+};
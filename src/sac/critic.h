@@ -1,12 +1,17 @@
 #pragma once
 #include <torch/torch.h>
 
-struct CriticImpl : torch::nn::Module {
+// Cloneable：snapshot() 用 clone() 深拷贝权重
+struct CriticImpl : torch::nn::Cloneable<CriticImpl> {
     torch::nn::Linear c1{nullptr}, c2{nullptr}, c3{nullptr};
-    int obs_dim, act_dim;
+    int obs_dim, act_dim, hidden;
 
-    CriticImpl(int obs_dim_=3, int act_dim_=1, int hidden=256)
-    : obs_dim(obs_dim_), act_dim(act_dim_) {
+    CriticImpl(int obs_dim_=3, int act_dim_=1, int hidden_=256)
+    : obs_dim(obs_dim_), act_dim(act_dim_), hidden(hidden_) {
+        reset();
+    }
+
+    void reset() override {
         c1 = register_module("c1", torch::nn::Linear(obs_dim + act_dim, hidden));
         c2 = register_module("c2", torch::nn::Linear(hidden, hidden));
         c3 = register_module("c3", torch::nn::Linear(hidden, 1));
@@ -16,7 +21,22 @@ struct CriticImpl : torch::nn::Module {
         auto x = torch::cat({s, a}, 1);
         x = torch::relu(c1->forward(x));
         x = torch::relu(c2->forward(x));
-        return c3->forward(x); // [B,1]
+        return c3->forward(x).to(torch::kFloat32); // [B,1]，autocast 下也以 fp32 参与 loss
+    }
+
+    // c1 按输入列拆成 state / action 两块：c1(cat(s,a)) = s·Ws^T + b + a·Wa^T。
+    // 权重仍是同一个 c1，checkpoint 格式不变。
+    torch::Tensor project_state(const torch::Tensor& s) {
+        return torch::nn::functional::linear(s, c1->weight.narrow(1, 0, obs_dim), c1->bias); // [B,hidden]
+    }
+
+    // hs = project_state(s)；动作部分用一次 addmm 加到 hs 上，不需要 cat。
+    // update() 中每个 critic 每个阶段只投影一次，没有复用：相比 cat 路径只省掉 cat，GEMM 由一次变为两次
+    torch::Tensor forward_projected(const torch::Tensor& hs, const torch::Tensor& a) {
+        auto x = torch::addmm(hs, a, c1->weight.narrow(1, obs_dim, act_dim).t());
+        x = torch::relu(x);
+        x = torch::relu(c2->forward(x));
+        return c3->forward(x).to(torch::kFloat32); // [B,1]
     }
 };
 TORCH_MODULE(Critic);
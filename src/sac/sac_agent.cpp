@@ -1,6 +1,35 @@
 #include "sac/sac_agent.h"
 #include <iostream>
 #include <filesystem>
+#include "runtime/flat_export.h"
+#include <ATen/autocast_mode.h>
+#include <ATen/CPUGeneratorImpl.h>
+#include <mutex>
+#include "utils/metrics.h"
+
+namespace {
+// CPU bf16 autocast 的作用域守卫；enabled=false 时什么也不做
+struct CpuAutocastGuard {
+    bool enabled;
+    bool prev_enabled = false;
+    at::ScalarType prev_dtype = at::kBFloat16;
+
+    explicit CpuAutocastGuard(bool on) : enabled(on) {
+        if (!enabled) return;
+        prev_enabled = at::autocast::is_autocast_enabled(at::kCPU);
+        prev_dtype   = at::autocast::get_autocast_dtype(at::kCPU);
+        at::autocast::set_autocast_dtype(at::kCPU, at::kBFloat16);
+        at::autocast::set_autocast_enabled(at::kCPU, true);
+        at::autocast::increment_nesting();
+    }
+    ~CpuAutocastGuard() {
+        if (!enabled) return;
+        if (at::autocast::decrement_nesting() == 0) at::autocast::clear_cache();
+        at::autocast::set_autocast_enabled(at::kCPU, prev_enabled);
+        at::autocast::set_autocast_dtype(at::kCPU, prev_dtype);
+    }
+};
+} // namespace
 
 SACAgent::SACAgent(const SACConfig& cfg, torch::Device device)
 : cfg_(cfg), device_(device),
@@ -49,54 +78,99 @@ double SACAgent::select_action_eval(const torch::Tensor& state_cpu) {
 
 void SACAgent::update(ReplayBuffer& buf) {
     if (buf.size() < (size_t)cfg_.batch_size) return;
+    ScopedPhase phase_update(Phase::kUpdate);
 
     auto [S, A, R, S2, D] = buf.sample(cfg_.batch_size, device_);
-    auto s  = S,  a = A,  r = R,  s2 = S2,  d = D;
+    update_on_batch(S, A, R, S2, D);
+}
+
+void SACAgent::update_on_batch(const torch::Tensor& S, const torch::Tensor& A, const torch::Tensor& R,
+                               const torch::Tensor& S2, const torch::Tensor& D) {
+    auto s  = S.to(device_),  a = A.to(device_),  r = R.to(device_),  s2 = S2.to(device_),  d = D.to(device_);
+
+    // bf16 autocast 只包住前向：网络输出、loss 与 log_alpha_ 都是 fp32，
+    // backward/optimizer.step 在 autocast 作用域之外执行（权重保持 fp32）。
+    const bool bf16 = cfg_.autocast_bf16;
+    const bool split = cfg_.critic_split;
 
     // ------- 1) target -------
     torch::Tensor target_q;
     {
+        ScopedPhase ph(Phase::kUpdateTarget);
         torch::NoGradGuard ng;
+        CpuAutocastGuard ac(bf16);
         auto [a2_01, logp2] = actor_->sample_action_and_logp(s2);
         auto a2 = scale_to_env_action(a2_01);
-        auto q1_t = tq1_->forward(s2, a2);
-        auto q2_t = tq2_->forward(s2, a2);
+        auto q1_t = split ? tq1_->forward_projected(tq1_->project_state(s2), a2) : tq1_->forward(s2, a2);
+        auto q2_t = split ? tq2_->forward_projected(tq2_->project_state(s2), a2) : tq2_->forward(s2, a2);
         auto min_q = torch::min(q1_t, q2_t);
         target_q = r + (1.0 - d) * cfg_.gamma * (min_q - alpha_value_ * logp2);
     }
 
     // ------- 2) update Qs -------
     {
+        ScopedPhase ph(Phase::kUpdateCritic);
         optim_q1_.zero_grad();
-        auto q1v = q1_->forward(s, a);
-        auto loss_q1 = torch::mse_loss(q1v, target_q);
+        torch::Tensor loss_q1;
+        {
+            CpuAutocastGuard ac(bf16);
+            auto q1v = split ? q1_->forward_projected(q1_->project_state(s), a) : q1_->forward(s, a);
+            loss_q1 = torch::mse_loss(q1v, target_q);
+        }
         loss_q1.backward();
         optim_q1_.step();
 
         optim_q2_.zero_grad();
-        auto q2v = q2_->forward(s, a);
-        auto loss_q2 = torch::mse_loss(q2v, target_q);
+        torch::Tensor loss_q2;
+        {
+            CpuAutocastGuard ac(bf16);
+            auto q2v = split ? q2_->forward_projected(q2_->project_state(s), a) : q2_->forward(s, a);
+            loss_q2 = torch::mse_loss(q2v, target_q);
+        }
         loss_q2.backward();
         optim_q2_.step();
     }
 
     // ------- 3) update Actor -------
     {
+        ScopedPhase ph(Phase::kUpdateActor);
         optim_actor_.zero_grad();
-        auto [a01, logp] = actor_->sample_action_and_logp(s);
-        auto a_new = scale_to_env_action(a01);
-        auto q1v = q1_->forward(s, a_new);
-        auto q2v = q2_->forward(s, a_new);
-        auto min_q = torch::min(q1v, q2v);
-        auto loss_actor = (alpha_value_ * logp - min_q).mean();
+        torch::Tensor loss_actor;
+        {
+            CpuAutocastGuard ac(bf16);
+            auto [a01, logp] = actor_->sample_action_and_logp(s);
+            auto a_new = scale_to_env_action(a01);
+            torch::Tensor q1v, q2v;
+            if (split) {
+                // actor loss 只需要对 a_new 的梯度：state 投影不进 autograd
+                torch::Tensor hs1, hs2;
+                {
+                    torch::NoGradGuard ng;
+                    hs1 = q1_->project_state(s);
+                    hs2 = q2_->project_state(s);
+                }
+                q1v = q1_->forward_projected(hs1, a_new);
+                q2v = q2_->forward_projected(hs2, a_new);
+            } else {
+                q1v = q1_->forward(s, a_new);
+                q2v = q2_->forward(s, a_new);
+            }
+            auto min_q = torch::min(q1v, q2v);
+            loss_actor = (alpha_value_ * logp - min_q).mean();
+        }
         loss_actor.backward();
         optim_actor_.step();
     }
 
     // ------- 4) update alpha -------
     if (cfg_.autotune_alpha) {
+        ScopedPhase ph(Phase::kUpdateAlpha);
         optim_alpha_.zero_grad();
-        auto [a01, logp] = actor_->sample_action_and_logp(s);
+        torch::Tensor logp;
+        {
+            CpuAutocastGuard ac(bf16);
+            logp = actor_->sample_action_and_logp(s).second;
+        }
         auto loss_alpha = (-log_alpha_ * (logp + cfg_.target_entropy).detach()).mean();
         loss_alpha.backward();
         optim_alpha_.step();
@@ -104,7 +178,11 @@ void SACAgent::update(ReplayBuffer& buf) {
     }
 
     // ------- 5) soft update -------
-    soft_update(cfg_.tau);
+    {
+        ScopedPhase ph(Phase::kSoftUpdate);
+        soft_update(cfg_.tau);
+    }
+    metrics().updates_total.fetch_add(1, std::memory_order_relaxed);
 }
 
 void SACAgent::soft_update(double tau) {
@@ -120,26 +198,87 @@ void SACAgent::soft_update(double tau) {
     update(tq2_, q2_);
 }
 
-// ----------------- Checkpoint -----------------
-void SACAgent::save(const std::string& dir) {
-    namespace fs = std::filesystem;
-    fs::create_directories(dir);
+// ----------------- Memory -----------------
+size_t SACAgent::parameter_bytes() {
+    size_t total = 0;
+    auto add = [&total](const std::vector<torch::Tensor>& params) {
+        for (const auto& p : params) {
+            total += p.nbytes();
+            if (p.grad().defined()) total += p.grad().nbytes();
+        }
+    };
+    add(actor_->parameters());
+    add(q1_->parameters());
+    add(q2_->parameters());
+    add(tq1_->parameters());
+    add(tq2_->parameters());
+    add({log_alpha_});
+    return total;
+}
 
-    // 网络参数
-    torch::save(actor_, fs::path(dir) / "actor.pt");
-    torch::save(q1_,    fs::path(dir) / "q1.pt");
-    torch::save(q2_,    fs::path(dir) / "q2.pt");
-    torch::save(tq1_,   fs::path(dir) / "tq1.pt");
-    torch::save(tq2_,   fs::path(dir) / "tq2.pt");
+size_t SACAgent::optimizer_state_bytes() {
+    size_t total = 0;
+    for (auto* opt : {&optim_actor_, &optim_q1_, &optim_q2_, &optim_alpha_}) {
+        for (const auto& kv : opt->state()) {
+            const auto& st = static_cast<const torch::optim::AdamParamState&>(*kv.second);
+            if (st.exp_avg().defined())        total += st.exp_avg().nbytes();
+            if (st.exp_avg_sq().defined())     total += st.exp_avg_sq().nbytes();
+            if (st.max_exp_avg_sq().defined()) total += st.max_exp_avg_sq().nbytes();
+        }
+    }
+    return total;
+}
 
-    // alpha 参数（用 tensor 存）
-    torch::save(log_alpha_, fs::path(dir) / "log_alpha.pt");
+// ----------------- Snapshot -----------------
+AgentSnapshot SACAgent::snapshot() const {
+    torch::NoGradGuard ng;
+    // Cloneable::clone() 内部会先 reset()（Kaiming 初始化要从全局生成器取数）再覆盖权重；
+    // 前后恢复生成器状态，使异步评估不改变给定 seed 下的训练轨迹
+    auto gen = at::detail::getDefaultCPUGenerator();
+    at::Tensor rng_state;
+    {
+        std::lock_guard<std::mutex> lk(gen.mutex());
+        rng_state = gen.get_state();
+    }
+    auto clone_critic = [](const Critic& c) { return Critic(std::dynamic_pointer_cast<CriticImpl>(c->clone())); };
+
+    AgentSnapshot snap;
+    snap.actor = Actor(std::dynamic_pointer_cast<ActorImpl>(actor_->clone()));
+    snap.q1  = clone_critic(q1_);
+    snap.q2  = clone_critic(q2_);
+    snap.tq1 = clone_critic(tq1_);
+    snap.tq2 = clone_critic(tq2_);
+    snap.log_alpha = log_alpha_.detach().clone();
+
+    std::lock_guard<std::mutex> lk(gen.mutex());
+    gen.set_state(rng_state);
+    return snap;
+}
+
+// ----------------- Checkpoint -----------------
+void SACAgent::save(const std::string& dir) {
+    save_snapshot(AgentSnapshot{actor_, q1_, q2_, tq1_, tq2_, log_alpha_}, dir);
 
     // （可选）也可以保存优化器状态，后续需要恢复学习率调度等再开启：
     // torch::save(optim_actor_, fs::path(dir) / "optim_actor.pt");
     // torch::save(optim_q1_,    fs::path(dir) / "optim_q1.pt");
     // torch::save(optim_q2_,    fs::path(dir) / "optim_q2.pt");
     // torch::save(optim_alpha_, fs::path(dir) / "optim_alpha.pt");
+}
+
+void SACAgent::save_snapshot(const AgentSnapshot& snap, const std::string& dir) {
+    namespace fs = std::filesystem;
+    fs::create_directories(dir);
+
+    // 网络参数
+    torch::save(snap.actor, fs::path(dir) / "actor.pt");
+    torch::save(snap.q1,    fs::path(dir) / "q1.pt");
+    torch::save(snap.q2,    fs::path(dir) / "q2.pt");
+    torch::save(snap.tq1,   fs::path(dir) / "tq1.pt");
+    torch::save(snap.tq2,   fs::path(dir) / "tq2.pt");
+
+    // alpha 参数（用 tensor 存）
+    torch::save(snap.log_alpha, fs::path(dir) / "log_alpha.pt");
     std::cout << "[checkpoint] saved to " << dir << "\n";
 }
 
@@ -179,3 +318,22 @@ bool SACAgent::load(const std::string& dir, torch::Device dev) {
         return false;
     }
 }
+
+// ----------------- Export -----------------
+bool SACAgent::export_policy(const std::string& path) {
+    std::vector<flat_policy::LayerWeights> layers;
+    for (const auto& lin : {actor_->fc1, actor_->fc2, actor_->mean})
+        layers.push_back(flat_policy::from_linear(lin));
+
+    namespace fs = std::filesystem;
+    const auto parent = fs::path(path).parent_path();
+    if (!parent.empty()) fs::create_directories(parent);
+
+    std::string err;
+    if (!flat_policy::write_file(path, (float)cfg_.act_limit, layers, &err)) {
+        std::cerr << "[export] failed: " << err << "\n";
+        return false;
+    }
+    std::cout << "[export] policy written to " << path << "\n";
+    return true;
+}
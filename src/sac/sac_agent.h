@@ -2,6 +2,7 @@
 #include <torch/torch.h>
 #include <string>
 #include <filesystem>
+#include <cmath>
 #include "sac/actor.h"
 #include "sac/critic.h"
 #include "utils/replay_buffer.h"
@@ -18,6 +19,17 @@ struct SACConfig {
     bool autotune_alpha = true;
     double target_entropy = -1.0; // for 1D action
     int updates_per_step = 1;
+    bool autocast_bf16 = false;   // CPU bf16 autocast 跑前向，权重与 alpha 保持 fp32
+    bool critic_split = false;    // critic 第一层拆成 state/action 两块：省掉 cat，但一次 GEMM 变为两次；默认关闭，bench 证明更快再开
+};
+
+// 某一时刻全部网络权重与 log_alpha 的深拷贝（后台评估 / best-model 保存用）
+struct AgentSnapshot {
+    Actor  actor{nullptr};
+    Critic q1{nullptr}, q2{nullptr}, tq1{nullptr}, tq2{nullptr};
+    torch::Tensor log_alpha;
+
+    double alpha() const { return std::exp(log_alpha.item<double>()); }
 };
 
 class SACAgent {
@@ -28,14 +40,32 @@ public:
     double select_action_eval(const torch::Tensor& state_cpu);
 
     void update(ReplayBuffer& buf);
+    // 对一批已采好的样本做一次 update（S[B,obs] A[B,act] R[B,1] S2[B,obs] D[B,1]）
+    void update_on_batch(const torch::Tensor& S, const torch::Tensor& A, const torch::Tensor& R,
+                         const torch::Tensor& S2, const torch::Tensor& D);
     void soft_update(double tau);
 
     // --- Checkpoint I/O ---
     void save(const std::string& dir);                 // 保存网络+alpha（含target）
     bool load(const std::string& dir, torch::Device);  // 读取，返回是否成功
 
+    // 拷贝当前权重（不含优化器状态），之后训练不会影响快照
+    AgentSnapshot snapshot() const;
+    // 按 save() 相同的文件布局保存快照
+    static void save_snapshot(const AgentSnapshot& snap, const std::string& dir);
+
+    // 导出 Actor 确定性策略为扁平权重文件（见 runtime/policy_runtime.h）
+    bool export_policy(const std::string& path);
+
+    Actor& actor() { return actor_; }
+    const SACConfig& config() const { return cfg_; }
+
     double alpha() const { return alpha_value_.item<double>(); }
 
+    // --- 内存统计 ---
+    size_t parameter_bytes();        // 所有网络参数 + 梯度 + log_alpha
+    size_t optimizer_state_bytes();  // Adam 的 exp_avg / exp_avg_sq 等
+
 private:
     SACConfig cfg_;
     torch::Device device_;
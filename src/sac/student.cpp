@@ -0,0 +1,56 @@
+#include "sac/student.h"
+#include "runtime/flat_export.h"
+#include <nlohmann/json.hpp>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+bool save_student(StudentPolicy& student, double act_limit, const std::string& dir) {
+    fs::create_directories(dir);
+    torch::save(student, fs::path(dir) / "student.pt");
+
+    json j = {
+        {"obs_dim",   student->obs_dim},
+        {"act_dim",   student->act_dim},
+        {"width",     student->width},
+        {"depth",     student->depth},
+        {"act_limit", act_limit}
+    };
+    std::ofstream out(fs::path(dir) / "student.json");
+    if (!out.is_open()) return false;
+    out << j.dump(2) << std::endl;
+
+    // 同时导出扁平格式，policy_runtime / realtime 可直接加载
+    std::vector<flat_policy::LayerWeights> layers;
+    for (size_t i = 0; i < student->layers->size(); ++i)
+        layers.push_back(flat_policy::from_linear(torch::nn::Linear(student->layers->ptr<torch::nn::LinearImpl>(i))));
+    std::string err;
+    if (!flat_policy::write_file((fs::path(dir) / "student.bin").string(), (float)act_limit, layers, &err)) {
+        std::cerr << "[student] flat export failed: " << err << "\n";
+        return false;
+    }
+    std::cout << "[student] saved to " << dir << "\n";
+    return true;
+}
+
+bool load_student(const std::string& dir, StudentPolicy& student, double& act_limit) {
+    std::ifstream in(fs::path(dir) / "student.json");
+    if (!in.is_open() || !fs::exists(fs::path(dir) / "student.pt")) {
+        std::cerr << "[student] missing files in " << dir << "\n";
+        return false;
+    }
+    try {
+        json j; in >> j;
+        student = StudentPolicy(j.value("obs_dim", 3), j.value("width", 32),
+                                j.value("depth", 2), j.value("act_dim", 1));
+        act_limit = j.value("act_limit", 2.0);
+        torch::load(student, fs::path(dir) / "student.pt");
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "[student] load failed: " << e.what() << "\n";
+        return false;
+    }
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <torch/torch.h>
+#include <string>
+
+// 蒸馏用的小型确定性策略：depth 个 ReLU 隐藏层（宽 width）+ tanh 输出（[-1,1]）
+struct StudentPolicyImpl : torch::nn::Module {
+    torch::nn::ModuleList layers{nullptr};
+    int obs_dim, act_dim, width, depth;
+
+    StudentPolicyImpl(int obs_dim_=3, int width_=32, int depth_=2, int act_dim_=1)
+    : obs_dim(obs_dim_), act_dim(act_dim_), width(width_), depth(depth_) {
+        layers = register_module("layers", torch::nn::ModuleList());
+        int in = obs_dim;
+        for (int i = 0; i < depth; ++i) {
+            layers->push_back(torch::nn::Linear(in, width));
+            in = width;
+        }
+        layers->push_back(torch::nn::Linear(in, act_dim));
+    }
+
+    torch::Tensor forward(torch::Tensor x) {
+        const size_t n = layers->size();
+        for (size_t i = 0; i < n; ++i) {
+            x = layers[i]->as<torch::nn::Linear>()->forward(x);
+            x = (i + 1 < n) ? torch::relu(x) : torch::tanh(x);
+        }
+        return x;
+    }
+};
+TORCH_MODULE(StudentPolicy);
+
+// 保存到 dir：student.pt（权重）+ student.json（结构与 act_limit）+ student.bin（扁平运行时格式）
+bool save_student(StudentPolicy& student, double act_limit, const std::string& dir);
+// 从 dir 读取结构并加载权重；失败返回 false
+bool load_student(const std::string& dir, StudentPolicy& student, double& act_limit);
@@ -0,0 +1,76 @@
+#pragma once
+// libtorch CPU 分配器统计：通过 c10 的内存上报接口（与 profiler 同一入口）
+// 记录分配次数、当前存活字节与峰值。用 c10::DebugInfoGuard 安装到线程上，
+// at::parallel_for 的工作线程会继承同一份 ThreadLocalDebugInfo。
+#include <c10/core/Allocator.h>
+#include <c10/util/ThreadLocalDebugInfo.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+class TorchAllocTracker : public c10::MemoryReportingInfoBase {
+public:
+    TorchAllocTracker() = default;
+    // 只更新 parent 的存活/峰值字节、不计分配次数的子 tracker：装到其他线程（如后台评估）上，
+    // 让那里的释放也被 c10 记账，同时不把那些分配混进 parent 的 allocs()/alloc_bytes() 差值
+    explicit TorchAllocTracker(std::shared_ptr<TorchAllocTracker> parent) : parent_(std::move(parent)) {}
+
+    bool memoryProfilingEnabled() const override { return true; }
+
+    void reportMemoryUsage(void* /*ptr*/, int64_t alloc_size, size_t total_allocated,
+                           size_t /*total_reserved*/, c10::Device device) override {
+        if (device.type() != c10::DeviceType::CPU) return;
+        if (parent_) {
+            parent_->update_live_(total_allocated);
+            return;
+        }
+        if (alloc_size > 0) {
+            allocs_.fetch_add(1, std::memory_order_relaxed);
+            alloc_bytes_.fetch_add(alloc_size, std::memory_order_relaxed);
+        }
+        update_live_(total_allocated);
+    }
+
+    // 累计分配次数 / 字节（用差值得到区间内的分配量）
+    uint64_t allocs() const      { return allocs_.load(std::memory_order_relaxed); }
+    uint64_t alloc_bytes() const { return (uint64_t)alloc_bytes_.load(std::memory_order_relaxed); }
+    // 安装以来经由 CPU 分配器申请、仍存活的字节数与其峰值
+    size_t live_bytes() const { return live_bytes_.load(std::memory_order_relaxed); }
+    size_t peak_bytes() const { return peak_bytes_.load(std::memory_order_relaxed); }
+
+private:
+    std::shared_ptr<TorchAllocTracker> parent_;
+    std::atomic<uint64_t> allocs_{0};
+    std::atomic<int64_t>  alloc_bytes_{0};
+    std::atomic<size_t>   live_bytes_{0};
+    std::atomic<size_t>   peak_bytes_{0};
+
+    // total_allocated 是 c10 的全进程计数，任何线程上报的都可直接作为存活字节
+    void update_live_(size_t total_allocated) {
+        live_bytes_.store(total_allocated, std::memory_order_relaxed);
+        size_t peak = peak_bytes_.load(std::memory_order_relaxed);
+        while (total_allocated > peak &&
+               !peak_bytes_.compare_exchange_weak(peak, total_allocated, std::memory_order_relaxed)) {}
+    }
+};
+
+// RAII：在当前作用域内把 tracker 装为 PROFILER_STATE（enabled=false 时不安装）
+class TorchAllocTrackerScope {
+public:
+    explicit TorchAllocTrackerScope(bool enabled)
+    : tracker_(enabled ? std::make_shared<TorchAllocTracker>() : nullptr)
+    {
+        if (tracker_)
+            guard_ = std::make_unique<c10::DebugInfoGuard>(c10::DebugInfoKind::PROFILER_STATE, tracker_);
+    }
+
+    TorchAllocTracker* get() const { return tracker_.get(); }
+    // 给其他线程安装的子 tracker（只更新存活/峰值字节）；未启用时返回 nullptr
+    std::shared_ptr<TorchAllocTracker> make_worker_tracker() const {
+        return tracker_ ? std::make_shared<TorchAllocTracker>(tracker_) : nullptr;
+    }
+
+private:
+    std::shared_ptr<TorchAllocTracker> tracker_;
+    std::unique_ptr<c10::DebugInfoGuard> guard_;
+};
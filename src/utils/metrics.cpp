@@ -0,0 +1,120 @@
+#include "utils/metrics.h"
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+TrainMetrics& metrics() {
+    static TrainMetrics m;
+    return m;
+}
+
+std::string render_prometheus(const TrainMetrics& m) {
+    static const char* kPhaseNames[(int)Phase::kCount] = {
+        "act", "env_step", "update", "update_target", "update_critic",
+        "update_actor", "update_alpha", "soft_update"
+    };
+    auto ld = [](const auto& a) { return a.load(std::memory_order_relaxed); };
+
+    std::ostringstream o;
+    o.precision(15);   // 计数器较大时不要走科学计数法丢精度
+    auto metric = [&o](const char* name, const char* type, const char* help, double v) {
+        o << "# HELP " << name << ' ' << help << '\n'
+          << "# TYPE " << name << ' ' << type << '\n'
+          << name << ' ' << v << '\n';
+    };
+    metric("sac_global_step", "counter", "Environment steps taken by train_loop.", (double)ld(m.global_step));
+    metric("sac_updates_total", "counter", "SACAgent::update calls.", (double)ld(m.updates_total));
+    metric("sac_steps_per_sec", "gauge", "Recent environment steps per second.", ld(m.steps_per_sec));
+    metric("sac_updates_per_sec", "gauge", "Recent updates per second.", ld(m.updates_per_sec));
+    metric("sac_replay_size", "gauge", "Transitions held by the replay buffer.", (double)ld(m.replay_size));
+    metric("sac_alpha", "gauge", "Current entropy temperature.", ld(m.alpha));
+    metric("sac_last_eval_return", "gauge", "Average return of the latest evaluation.", ld(m.last_eval_return));
+    metric("sac_last_eval_step", "gauge", "Training step of the latest evaluation.", (double)ld(m.last_eval_step));
+
+    const double ckpt = ld(m.last_checkpoint_unix);
+    const double now = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+    metric("sac_checkpoint_age_seconds", "gauge", "Seconds since the last checkpoint (-1 if none).",
+           ckpt > 0.0 ? now - ckpt : -1.0);
+
+    o << "# HELP sac_phase_seconds_total Cumulative time spent per phase.\n"
+         "# TYPE sac_phase_seconds_total counter\n";
+    for (int i=0; i<(int)Phase::kCount; ++i)
+        o << "sac_phase_seconds_total{phase=\"" << kPhaseNames[i] << "\"} "
+          << ld(m.phases[i].total_ns) * 1e-9 << '\n';
+    o << "# HELP sac_phase_calls_total Calls per phase.\n"
+         "# TYPE sac_phase_calls_total counter\n";
+    for (int i=0; i<(int)Phase::kCount; ++i)
+        o << "sac_phase_calls_total{phase=\"" << kPhaseNames[i] << "\"} " << ld(m.phases[i].count) << '\n';
+    o << "# HELP sac_phase_last_seconds Latency of the most recent call per phase.\n"
+         "# TYPE sac_phase_last_seconds gauge\n";
+    for (int i=0; i<(int)Phase::kCount; ++i)
+        o << "sac_phase_last_seconds{phase=\"" << kPhaseNames[i] << "\"} "
+          << ld(m.phases[i].last_ns) * 1e-9 << '\n';
+    return o.str();
+}
+
+bool MetricsServer::start(int port) {
+    if (running_) return true;
+    fd_ = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (fd_ < 0) return false;
+    int one = 1;
+    ::setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::bind(fd_, (sockaddr*)&addr, sizeof(addr)) != 0 || ::listen(fd_, 8) != 0) {
+        std::cerr << "[metrics] cannot listen on 127.0.0.1:" << port << ": " << std::strerror(errno) << "\n";
+        ::close(fd_); fd_ = -1;
+        return false;
+    }
+    running_ = true;
+    thread_ = std::thread([this] { serve_(); });
+    std::cout << "[metrics] serving http://127.0.0.1:" << port << "/metrics\n";
+    return true;
+}
+
+void MetricsServer::stop() {
+    if (!running_.exchange(false)) return;
+    if (thread_.joinable()) thread_.join();
+    ::close(fd_); fd_ = -1;
+}
+
+void MetricsServer::serve_() {
+    while (running_) {
+        pollfd p{fd_, POLLIN, 0};
+        if (::poll(&p, 1, 200) <= 0) continue;   // 超时后检查 running_
+        int c = ::accept(fd_, nullptr, nullptr);
+        if (c < 0) continue;
+
+        // 读掉请求头（内容不关心），最多等 200ms
+        timeval tv{0, 200000};
+        ::setsockopt(c, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        char req[1024];
+        (void)::recv(c, req, sizeof(req), 0);
+
+        const std::string body = render_prometheus(metrics());
+        std::ostringstream resp;
+        resp << "HTTP/1.1 200 OK\r\n"
+                "Content-Type: text/plain; version=0.0.4\r\n"
+                "Content-Length: " << body.size() << "\r\n"
+                "Connection: close\r\n\r\n" << body;
+        const std::string out = resp.str();
+        size_t sent = 0;
+        while (sent < out.size()) {
+            ssize_t n = ::send(c, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) break;
+            sent += (size_t)n;
+        }
+        ::close(c);
+    }
+}
@@ -0,0 +1,85 @@
+#pragma once
+// 训练指标：热路径上只做 relaxed 原子写，抓取线程只读，二者互不阻塞。
+// MetricsServer 在 127.0.0.1:<port> 上以 Prometheus 文本格式提供 /metrics。
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+enum class Phase : int {
+    kAct = 0,        // 训练时选动作
+    kEnvStep,        // 环境一步
+    kUpdate,         // 整个 SACAgent::update
+    kUpdateTarget,   // 计算 target Q
+    kUpdateCritic,   // 两个 critic 的前向/反向/step
+    kUpdateActor,
+    kUpdateAlpha,
+    kSoftUpdate,
+    kCount
+};
+
+struct PhaseStat {
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> total_ns{0};
+    std::atomic<uint64_t> last_ns{0};
+};
+
+struct TrainMetrics {
+    std::atomic<uint64_t> global_step{0};
+    std::atomic<uint64_t> updates_total{0};
+    std::atomic<double>   steps_per_sec{0.0};
+    std::atomic<double>   updates_per_sec{0.0};
+    std::atomic<uint64_t> replay_size{0};
+    std::atomic<double>   alpha{0.0};
+    std::atomic<double>   last_eval_return{0.0};
+    std::atomic<uint64_t> last_eval_step{0};
+    std::atomic<double>   last_checkpoint_unix{0.0};   // 0 表示还没保存过
+    PhaseStat phases[(int)Phase::kCount];
+
+    void record(Phase p, uint64_t ns) {
+        auto& s = phases[(int)p];
+        s.count.fetch_add(1, std::memory_order_relaxed);
+        s.total_ns.fetch_add(ns, std::memory_order_relaxed);
+        s.last_ns.store(ns, std::memory_order_relaxed);
+    }
+    template <typename T, typename V>
+    static void set(std::atomic<T>& a, V v) { a.store((T)v, std::memory_order_relaxed); }
+};
+
+// 进程内唯一的一份指标
+TrainMetrics& metrics();
+
+// RAII：统计一个阶段的耗时
+class ScopedPhase {
+public:
+    explicit ScopedPhase(Phase p) : p_(p), t0_(std::chrono::steady_clock::now()) {}
+    ~ScopedPhase() {
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0_).count();
+        metrics().record(p_, (uint64_t)ns);
+    }
+private:
+    Phase p_;
+    std::chrono::steady_clock::time_point t0_;
+};
+
+// 渲染为 Prometheus text format (0.0.4)
+std::string render_prometheus(const TrainMetrics& m);
+
+// 极简 HTTP 服务器：单独线程 accept，任何请求都返回 /metrics 内容
+class MetricsServer {
+public:
+    MetricsServer() = default;
+    ~MetricsServer() { stop(); }
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    bool start(int port);   // 绑定 127.0.0.1:port，失败返回 false
+    void stop();
+
+private:
+    int fd_ = -1;
+    std::atomic<bool> running_{false};
+    std::thread thread_;
+    void serve_();
+};
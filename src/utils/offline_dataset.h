@@ -0,0 +1,236 @@
+#pragma once
+// 离线数据集：分块二进制文件，记录 (s, a, r, s2, d)。
+//
+// 文件格式（小端 float32 / uint32），version 1：
+//   [0]  char   magic[4] = "SACD"
+//   [4]  uint32 version
+//   [8]  uint32 obs_dim
+//   [12] uint32 act_dim
+//   [16] uint32 chunk_records   每块记录数（读端按块预读/释放）
+//   [20] uint32 reserved
+//   之后是连续记录，每条 2*obs_dim + act_dim + 2 个 float：s, a, r, s2, d
+// 读端用 mmap 顺序流式读取：预读下一块（MADV_WILLNEED），
+// 丢弃已读完的块（MADV_DONTNEED），因此常驻内存与文件大小无关。
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+constexpr char     kOfflineMagic[4] = {'S', 'A', 'C', 'D'};
+constexpr uint32_t kOfflineVersion  = 1;
+constexpr size_t   kOfflineHeaderBytes = 24;
+
+class OfflineDatasetWriter {
+public:
+    // append=true 且文件已存在时接着写：校验文件头维度，截掉末尾不完整的记录，不再写文件头
+    OfflineDatasetWriter(const std::string& path, int obs_dim, int act_dim,
+                         uint32_t chunk_records = 65536, bool append = false)
+    : obs_dim_(obs_dim), act_dim_(act_dim)
+    {
+        namespace fs = std::filesystem;
+        const auto parent = fs::path(path).parent_path();
+        if (!parent.empty()) fs::create_directories(parent);
+        row_.resize(2 * obs_dim + act_dim + 2);
+
+        std::error_code ec;
+        const uintmax_t old_size = append && fs::exists(path, ec) ? fs::file_size(path, ec) : 0;
+        if (old_size >= kOfflineHeaderBytes) {
+            uint32_t hdr[6] = {0};
+            FILE* in = std::fopen(path.c_str(), "rb");
+            const bool read_ok = in && std::fread(hdr, 4, 6, in) == 6;
+            if (in) std::fclose(in);
+            if (!read_ok || std::memcmp(&hdr[0], kOfflineMagic, 4) != 0 || hdr[1] != kOfflineVersion ||
+                hdr[2] != (uint32_t)obs_dim || hdr[3] != (uint32_t)act_dim)
+                throw std::runtime_error("OfflineDatasetWriter: cannot append, header mismatch: " + path);
+            const uintmax_t row_bytes = row_.size() * sizeof(float);
+            count_ = (size_t)((old_size - kOfflineHeaderBytes) / row_bytes);
+            fs::resize_file(path, kOfflineHeaderBytes + count_ * row_bytes, ec);
+            if (ec) throw std::runtime_error("OfflineDatasetWriter: cannot truncate partial record: " + path);
+            f_ = std::fopen(path.c_str(), "ab");
+            if (!f_) throw std::runtime_error("OfflineDatasetWriter: cannot open file: " + path);
+            return;
+        }
+
+        f_ = std::fopen(path.c_str(), "wb");
+        if (!f_) throw std::runtime_error("OfflineDatasetWriter: cannot open file: " + path);
+        uint32_t hdr[6] = {0, kOfflineVersion, (uint32_t)obs_dim, (uint32_t)act_dim, chunk_records, 0};
+        std::memcpy(&hdr[0], kOfflineMagic, 4);
+        std::fwrite(hdr, 4, 6, f_);
+    }
+    ~OfflineDatasetWriter() { if (f_) std::fclose(f_); }
+
+    void write(const float* s, const float* a, float r, const float* s2, float d) {
+        float* p = row_.data();
+        std::copy(s, s + obs_dim_, p);  p += obs_dim_;
+        std::copy(a, a + act_dim_, p);  p += act_dim_;
+        *p++ = r;
+        std::copy(s2, s2 + obs_dim_, p); p += obs_dim_;
+        *p = d;
+        std::fwrite(row_.data(), sizeof(float), row_.size(), f_);
+        ++count_;
+    }
+
+    size_t count() const { return count_; }   // 文件中的记录总数（续写时含已有记录）
+    void flush() { std::fflush(f_); }
+
+private:
+    int obs_dim_, act_dim_;
+    FILE* f_ = nullptr;
+    std::vector<float> row_;
+    size_t count_ = 0;
+};
+
+class OfflineDatasetReader {
+public:
+    explicit OfflineDatasetReader(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("OfflineDatasetReader: cannot open file: " + path);
+        struct stat st{};
+        if (::fstat(fd, &st) != 0 || st.st_size < (off_t)kOfflineHeaderBytes) {
+            ::close(fd);
+            throw std::runtime_error("OfflineDatasetReader: file too small: " + path);
+        }
+        size_ = (size_t)st.st_size;
+        void* p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) throw std::runtime_error("OfflineDatasetReader: mmap failed: " + path);
+        base_ = static_cast<const char*>(p);
+
+        const auto* hdr = reinterpret_cast<const uint32_t*>(base_);
+        if (std::memcmp(base_, kOfflineMagic, 4) != 0 || hdr[1] != kOfflineVersion) {
+            ::munmap(const_cast<char*>(base_), size_);
+            throw std::runtime_error("OfflineDatasetReader: bad header: " + path);
+        }
+        obs_dim_ = (int)hdr[2];
+        act_dim_ = (int)hdr[3];
+        chunk_records_ = std::max<uint32_t>(1, hdr[4]);
+        row_floats_ = 2 * obs_dim_ + act_dim_ + 2;
+        records_ = (size_ - kOfflineHeaderBytes) / (row_floats_ * sizeof(float));
+
+        ::madvise(const_cast<char*>(base_), size_, MADV_SEQUENTIAL);
+        rewind();
+    }
+    ~OfflineDatasetReader() { if (base_) ::munmap(const_cast<char*>(base_), size_); }
+
+    OfflineDatasetReader(const OfflineDatasetReader&) = delete;
+    OfflineDatasetReader& operator=(const OfflineDatasetReader&) = delete;
+
+    int obs_dim() const { return obs_dim_; }
+    int act_dim() const { return act_dim_; }
+    int row_floats() const { return row_floats_; }
+    size_t records() const { return records_; }
+
+    // 回到文件开头（开始新的一轮 epoch）
+    void rewind() {
+        release_(0, pos_);
+        pos_ = 0;
+        prefetched_ = 0;
+        prefetch_();
+    }
+
+    // 顺序读取下一条记录；到文件末尾返回 nullptr。返回的指针至少在读完下一块之前有效。
+    const float* next() {
+        if (pos_ >= records_) return nullptr;
+        const float* row = row_ptr_(pos_);
+        ++pos_;
+        if (pos_ % chunk_records_ == 0) {
+            // 释放上一块（当前块刚返回的指针仍需有效）
+            if (pos_ >= 2 * (size_t)chunk_records_)
+                release_(pos_ - 2 * (size_t)chunk_records_, pos_ - chunk_records_);
+            prefetch_();
+        }
+        return row;
+    }
+
+private:
+    const char* base_ = nullptr;
+    size_t size_ = 0;
+    int obs_dim_ = 0, act_dim_ = 0, row_floats_ = 0;
+    uint32_t chunk_records_ = 1;
+    size_t records_ = 0;
+    size_t pos_ = 0;
+    size_t prefetched_ = 0;   // 已发出预读的记录上界
+
+    const float* row_ptr_(size_t i) const {
+        return reinterpret_cast<const float*>(base_ + kOfflineHeaderBytes) + i * row_floats_;
+    }
+
+    // 对 [begin, end) 记录所在页执行 madvise（向内取整到页边界）
+    void advise_(size_t begin, size_t end, int advice, bool shrink) {
+        if (end <= begin) return;
+        static const size_t page = (size_t)::sysconf(_SC_PAGESIZE);
+        size_t b = kOfflineHeaderBytes + begin * row_floats_ * sizeof(float);
+        size_t e = kOfflineHeaderBytes + std::min(end, records_) * row_floats_ * sizeof(float);
+        if (shrink) { b = (b + page - 1) / page * page; e = e / page * page; }
+        else        { b = b / page * page; }
+        if (e <= b) return;
+        ::madvise(const_cast<char*>(base_) + b, e - b, advice);
+    }
+
+    // 预读当前块之后的两块
+    void prefetch_() {
+        size_t target = std::min(records_, pos_ + 2 * (size_t)chunk_records_);
+        if (target > prefetched_) {
+            advise_(std::max(prefetched_, pos_), target, MADV_WILLNEED, false);
+            prefetched_ = target;
+        }
+    }
+
+    void release_(size_t begin, size_t end) { advise_(begin, end, MADV_DONTNEED, true); }
+};
+
+// 有界窗口内的随机打乱：窗口填满后随机取出一条，并用新读入的记录替换。
+class ShuffleWindow {
+public:
+    ShuffleWindow(OfflineDatasetReader& reader, size_t window, unsigned seed)
+    : reader_(reader), window_(std::max<size_t>(1, window)),
+      width_(reader.row_floats()), rng_(seed)
+    {
+        data_.reserve(window_ * width_);
+    }
+
+    // 取下一条记录（拷贝到 out，长度 row_floats）；数据读完且窗口为空时返回 false
+    bool next(float* out) {
+        while (count_ < window_) {
+            const float* row = reader_.next();
+            if (!row) break;
+            data_.insert(data_.end(), row, row + width_);
+            ++count_;
+        }
+        if (count_ == 0) return false;
+
+        std::uniform_int_distribution<size_t> uni(0, count_ - 1);
+        size_t k = uni(rng_);
+        float* slot = data_.data() + k * width_;
+        std::copy(slot, slot + width_, out);
+
+        // 用新记录填补；没有新记录则把末尾挪过来
+        if (const float* row = reader_.next()) {
+            std::copy(row, row + width_, slot);
+        } else {
+            float* last = data_.data() + (count_ - 1) * width_;
+            if (last != slot) std::copy(last, last + width_, slot);
+            data_.resize((count_ - 1) * width_);
+            --count_;
+        }
+        return true;
+    }
+
+private:
+    OfflineDatasetReader& reader_;
+    size_t window_;
+    int width_;
+    std::mt19937 rng_;
+    std::vector<float> data_;
+    size_t count_ = 0;
+};
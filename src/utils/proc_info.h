@@ -0,0 +1,71 @@
+#pragma once
+// 进程信息（Linux /proc），不依赖 libtorch，可被 policy_runtime 复用。
+#include <cstddef>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <filesystem>
+#include <time.h>
+#include <unistd.h>
+
+// 当前可执行文件大小（字节）
+inline size_t self_exe_bytes() {
+    std::error_code ec;
+    auto p = std::filesystem::read_symlink("/proc/self/exe", ec);
+    if (ec) return 0;
+    auto n = std::filesystem::file_size(p, ec);
+    return ec ? 0 : (size_t)n;
+}
+
+// 读取 /proc/self/status 中的某一项（单位 kB），返回字节数
+inline size_t proc_status_bytes(const std::string& key) {
+    std::ifstream in("/proc/self/status");
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.compare(0, key.size(), key) == 0 && line.size() > key.size() && line[key.size()] == ':')
+            return (size_t)std::stoull(line.substr(key.size() + 1)) * 1024;
+    }
+    return 0;
+}
+inline size_t process_rss_bytes()      { return proc_status_bytes("VmRSS"); }
+inline size_t process_peak_rss_bytes() { return proc_status_bytes("VmHWM"); }
+
+// 已映射的共享库文件总大小（字节，按文件去重），用来衡量部署体积
+inline size_t mapped_library_bytes() {
+    std::ifstream in("/proc/self/maps");
+    std::set<std::string> files;
+    std::string line;
+    while (std::getline(in, line)) {
+        auto pos = line.find('/');
+        if (pos == std::string::npos) continue;
+        std::string path = line.substr(pos);
+        if (path.find(".so") != std::string::npos) files.insert(path);
+    }
+    size_t total = 0;
+    for (const auto& f : files) {
+        std::error_code ec;
+        auto n = std::filesystem::file_size(f, ec);
+        if (!ec) total += (size_t)n;
+    }
+    return total;
+}
+
+// 进程创建（fork/exec 前的 starttime）至今的微秒数，包含 exec 与动态链接耗时。
+// 来自 /proc/self/stat 第 22 项，精度为 1/CLK_TCK（通常 10ms）；读取失败返回 -1
+inline double process_age_us() {
+    std::ifstream in("/proc/self/stat");
+    std::string line;
+    std::getline(in, line);
+    const auto rp = line.rfind(')');           // comm 可能含空格，从最后一个 ')' 之后开始数
+    if (rp == std::string::npos) return -1.0;
+    std::istringstream is(line.substr(rp + 1));
+    std::string tok;
+    for (int field = 3; field < 22; ++field) is >> tok;
+    unsigned long long start_ticks = 0;
+    if (!(is >> start_ticks)) return -1.0;
+    timespec now{};
+    ::clock_gettime(CLOCK_BOOTTIME, &now);
+    const double start_s = (double)start_ticks / (double)::sysconf(_SC_CLK_TCK);
+    return ((double)now.tv_sec + now.tv_nsec * 1e-9 - start_s) * 1e6;
+}
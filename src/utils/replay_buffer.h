@@ -1,57 +1,195 @@
 #pragma once
 #include <torch/torch.h>
-#include <deque>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
 #include <random>
+#include <vector>
 
-struct Transition {
-    torch::Tensor s;   // [obs_dim]
-    torch::Tensor a;   // [act_dim]  (真实动作范围 [-2,2])
-    torch::Tensor r;   // [1]
-    torch::Tensor s2;  // [obs_dim]
-    torch::Tensor d;   // [1]  done (float 0/1)
-};
-
+// 环形回放缓冲，按列存储：
+//   obs_ [capacity, obs_dim]  每个观测只存一次（s）
+//   act_ [capacity, act_dim]  动作（真实范围 [-2,2]）
+//   rew_ [capacity]           fp32
+//   done_bits_ / linked_bits_ 位图
+// 同一回合内 s2(t) == s(t+1)，此时 linked 位为 1，s2 直接取下一个槽位的 obs；
+// 回合边界（或最新一条）的 s2 单独存入 tail_pool_（fp32）。
+// obs/act 可选 fp16/bf16 存储，sample() 时统一解码为 fp32。
 class ReplayBuffer {
 public:
-    ReplayBuffer(size_t capacity, int obs_dim, int act_dim)
-    : capacity_(capacity), obs_dim_(obs_dim), act_dim_(act_dim), rng_(123) {}
+    ReplayBuffer(size_t capacity, int obs_dim, int act_dim,
+                 torch::Dtype storage_dtype = torch::kFloat32)
+    : capacity_(capacity), obs_dim_(obs_dim), act_dim_(act_dim),
+      storage_dtype_(storage_dtype), rng_(123)
+    {
+        auto opt = torch::TensorOptions().dtype(storage_dtype_);
+        obs_ = torch::empty({(long)capacity_, obs_dim_}, opt);
+        act_ = torch::empty({(long)capacity_, act_dim_}, opt);
+        rew_.resize(capacity_);
+        done_bits_.assign((capacity_ + 63) / 64, 0);
+        linked_bits_.assign((capacity_ + 63) / 64, 0);
+        tail_row_.assign(capacity_, kNoTail);
+        last_s2_.resize(obs_dim_);
+    }
 
     void push(const torch::Tensor& s, const torch::Tensor& a,
               const torch::Tensor& r, const torch::Tensor& s2,
               const torch::Tensor& d) {
-        if (data_.size() >= capacity_) data_.pop_front();
-        data_.push_back(Transition{ s.detach().cpu(), a.detach().cpu(),
-                                    r.detach().cpu(), s2.detach().cpu(),
-                                    d.detach().cpu() });
+        auto f = [](const torch::Tensor& t) { return t.detach().to(torch::kCPU, torch::kFloat32).contiguous(); };
+        auto s_ = f(s), a_ = f(a), r_ = f(r), s2_ = f(s2), d_ = f(d);
+        push(s_.data_ptr<float>(), a_.data_ptr<float>(), r_.item<float>(),
+             s2_.data_ptr<float>(), d_.item<float>());
+    }
+
+    // 原始指针版本（免去逐步构造张量）
+    void push(const float* s, const float* a, float r, const float* s2, float d) {
+        const size_t slot = head_;
+        if (size_ == capacity_) {
+            // 覆盖最旧的一条
+            free_tail_(slot);
+            set_bit_(linked_bits_, slot, false);
+        }
+
+        store_row_(obs_, slot, s, obs_dim_);
+        store_row_(act_, slot, a, act_dim_);
+        rew_[slot] = r;
+        set_bit_(done_bits_, slot, d > 0.5f);
+
+        // 上一条的 s2 与本条 s 完全相同 -> 去重
+        if (size_ > 0 && capacity_ > 1) {
+            const size_t prev = (slot + capacity_ - 1) % capacity_;
+            if (std::equal(s, s + obs_dim_, last_s2_.begin())) {
+                set_bit_(linked_bits_, prev, true);
+                free_tail_(prev);
+            }
+        }
+
+        // 本条的 s2 先存入 tail，等下一条确认是否可链接
+        set_bit_(linked_bits_, slot, false);
+        alloc_tail_(slot, s2);
+        std::copy(s2, s2 + obs_dim_, last_s2_.begin());
+
+        head_ = (head_ + 1) % capacity_;
+        if (size_ < capacity_) ++size_;
+    }
+
+    // 批量写入 n 条（行主序，连续存放）
+    void push_batch(const float* S, const float* A, const float* R,
+                    const float* S2, const float* D, size_t n) {
+        for (size_t i=0; i<n; ++i)
+            push(S + i * obs_dim_, A + i * act_dim_, R[i], S2 + i * obs_dim_, D[i]);
     }
 
-    size_t size() const { return data_.size(); }
+    size_t size() const { return size_; }
+    int obs_dim() const { return obs_dim_; }
+    int act_dim() const { return act_dim_; }
+
+    // 缓冲区实际占用的字节数（列存储 + 位图 + tail 池）
+    size_t memory_bytes() const {
+        return obs_.nbytes() + act_.nbytes()
+             + rew_.capacity() * sizeof(float)
+             + (done_bits_.capacity() + linked_bits_.capacity()) * sizeof(uint64_t)
+             + tail_row_.capacity() * sizeof(uint32_t)
+             + tail_pool_.capacity() * sizeof(float)
+             + tail_free_.capacity() * sizeof(uint32_t)
+             + last_s2_.capacity() * sizeof(float);
+    }
 
     // 返回 batch 张量（在 device 上）
     std::tuple<torch::Tensor,torch::Tensor,torch::Tensor,torch::Tensor,torch::Tensor>
     sample(size_t batch_size, torch::Device device) {
-        std::uniform_int_distribution<size_t> uni(0, data_.size()-1);
-
-        auto S  = torch::empty({(long)batch_size, obs_dim_}, torch::kFloat32);
-        auto A  = torch::empty({(long)batch_size, act_dim_}, torch::kFloat32);
-        auto R  = torch::empty({(long)batch_size, 1},        torch::kFloat32);
-        auto S2 = torch::empty({(long)batch_size, obs_dim_}, torch::kFloat32);
-        auto D  = torch::empty({(long)batch_size, 1},        torch::kFloat32);
-
-        for (size_t i=0; i<batch_size; ++i) {
-            const auto& tr = data_[uni(rng_)];
-            S[i]  = tr.s;
-            A[i]  = tr.a;
-            R[i]  = tr.r;
-            S2[i] = tr.s2;
-            D[i]  = tr.d;
+        std::uniform_int_distribution<size_t> uni(0, size_-1);
+        const size_t oldest = (size_ < capacity_) ? 0 : head_;
+        const long B = (long)batch_size;
+
+        auto idx  = torch::empty({B}, torch::kInt64);
+        auto nidx = torch::empty({B}, torch::kInt64);
+        auto R  = torch::empty({B, 1}, torch::kFloat32);
+        auto D  = torch::empty({B, 1}, torch::kFloat32);
+        int64_t* ip = idx.data_ptr<int64_t>();
+        int64_t* np = nidx.data_ptr<int64_t>();
+        float* rp = R.data_ptr<float>();
+        float* dp = D.data_ptr<float>();
+
+        for (long i=0; i<B; ++i) {
+            const size_t slot = (oldest + uni(rng_)) % capacity_;
+            ip[i] = (int64_t)slot;
+            // 未链接的行先占位，稍后用 tail 覆盖
+            np[i] = (int64_t)(get_bit_(linked_bits_, slot) ? (slot + 1) % capacity_ : slot);
+            rp[i] = rew_[slot];
+            dp[i] = get_bit_(done_bits_, slot) ? 1.0f : 0.0f;
+        }
+
+        auto S  = obs_.index_select(0, idx).to(torch::kFloat32);
+        auto A  = act_.index_select(0, idx).to(torch::kFloat32);
+        auto S2 = obs_.index_select(0, nidx).to(torch::kFloat32).contiguous();
+
+        float* s2p = S2.data_ptr<float>();
+        for (long i=0; i<B; ++i) {
+            const size_t slot = (size_t)ip[i];
+            if (get_bit_(linked_bits_, slot)) continue;
+            const float* t = tail_pool_.data() + (size_t)tail_row_[slot] * obs_dim_;
+            std::copy(t, t + obs_dim_, s2p + i * obs_dim_);
         }
         return {S.to(device), A.to(device), R.to(device), S2.to(device), D.to(device)};
     }
 
 private:
+    static constexpr uint32_t kNoTail = std::numeric_limits<uint32_t>::max();
+
     size_t capacity_;
     int obs_dim_, act_dim_;
-    std::deque<Transition> data_;
+    torch::Dtype storage_dtype_;
     std::mt19937 rng_;
+
+    size_t head_ = 0, size_ = 0;
+    torch::Tensor obs_, act_;
+    std::vector<float> rew_;
+    std::vector<uint64_t> done_bits_, linked_bits_;
+
+    // 回合边界处的 s2：tail_row_[slot] 指向 tail_pool_ 中的一行
+    std::vector<uint32_t> tail_row_;
+    std::vector<float> tail_pool_;
+    std::vector<uint32_t> tail_free_;
+    std::vector<float> last_s2_;
+
+    static bool get_bit_(const std::vector<uint64_t>& bits, size_t i) {
+        return (bits[i >> 6] >> (i & 63)) & 1ull;
+    }
+    static void set_bit_(std::vector<uint64_t>& bits, size_t i, bool v) {
+        const uint64_t m = 1ull << (i & 63);
+        if (v) bits[i >> 6] |= m; else bits[i >> 6] &= ~m;
+    }
+
+    void alloc_tail_(size_t slot, const float* s2) {
+        uint32_t row;
+        if (!tail_free_.empty()) { row = tail_free_.back(); tail_free_.pop_back(); }
+        else { row = (uint32_t)(tail_pool_.size() / obs_dim_); tail_pool_.resize(tail_pool_.size() + obs_dim_); }
+        std::copy(s2, s2 + obs_dim_, tail_pool_.begin() + (size_t)row * obs_dim_);
+        tail_row_[slot] = row;
+    }
+    void free_tail_(size_t slot) {
+        if (tail_row_[slot] == kNoTail) return;
+        tail_free_.push_back(tail_row_[slot]);
+        tail_row_[slot] = kNoTail;
+    }
+
+    void store_row_(torch::Tensor& col, size_t row, const float* src, int n) {
+        const size_t off = row * (size_t)n;
+        switch (storage_dtype_) {
+            case torch::kHalf: {
+                auto* dst = col.data_ptr<at::Half>() + off;
+                for (int j=0; j<n; ++j) dst[j] = at::Half(src[j]);
+                break;
+            }
+            case torch::kBFloat16: {
+                auto* dst = col.data_ptr<at::BFloat16>() + off;
+                for (int j=0; j<n; ++j) dst[j] = at::BFloat16(src[j]);
+                break;
+            }
+            default: {
+                std::copy(src, src + n, col.data_ptr<float>() + off);
+                break;
+            }
+        }
+    }
 };